@@ -1,12 +1,67 @@
 #ifndef VIRTUAL_JOYSTICK_H
 #define VIRTUAL_JOYSTICK_H
 
+// Strict ISO modes (e.g. -std=c99) hide POSIX functions such as ftruncate, so ask for them before
+// the first system header. This only works if this header is included first; in the default GNU
+// modes they are visible anyway, and defining the macro there would hide other extensions.
+#if defined(__STRICT_ANSI__) && (defined(__unix__) || defined(__APPLE__)) && !defined(_POSIX_C_SOURCE) && \
+    !defined(_XOPEN_SOURCE) && !defined(_GNU_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <SDL2/SDL.h> // If you are viewing this code in a public view (for example, in GitHub), then I advise you to change this path to your real path so that the code works correctly.
 #include <stdbool.h>
 #include <math.h>
 #include <stdio.h>  // For fprintf, printf
 #include <stdlib.h> // For malloc, free
 
+// Memory mapping for the on-disk bitmap cache; other platforms read the cache file instead.
+#if defined(__unix__) || defined(__APPLE__)
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define VIRTUAL_JOYSTICK_HAS_MMAP 1
+#else
+    #define VIRTUAL_JOYSTICK_HAS_MMAP 0
+#endif
+
+// POSIX shared memory for publishing joystick state to other processes (Android has no shm_open).
+#if VIRTUAL_JOYSTICK_HAS_MMAP && !defined(__ANDROID__)
+    #define VIRTUAL_JOYSTICK_HAS_SHARED_MEMORY 1
+#else
+    #define VIRTUAL_JOYSTICK_HAS_SHARED_MEMORY 0
+#endif
+
+// --- Build Configuration ---
+// Like other single-header libraries, the header only declares the API unless told otherwise:
+//   VIRTUAL_JOYSTICK_IMPLEMENTATION: define it in exactly one .c/.cpp file before including the
+//       header to compile the functions there. Every other file includes the header plainly.
+//   VIRTUAL_JOYSTICK_DEMO: also compiles the demo's main function (implies the implementation).
+//   VIRTUAL_JOYSTICK_STATIC: makes every function static inline in each file that includes the
+//       header, so the compiler can inline and specialize calls such as HandleEvent into the
+//       caller's event loop. Each such file gets a private copy of the library, including its own
+//       texture sets, shared bitmaps and change queue, so use it in one file (or not share
+//       joysticks between files).
+//   VIRTUAL_JOYSTICK_API: may be predefined to decorate the public functions (e.g. for exporting
+//       them from a shared library).
+// VIRTUAL_JOYSTICK_NO_MAIN is still accepted for older code but no longer has any effect.
+#ifdef VIRTUAL_JOYSTICK_NO_MAIN
+    #ifdef _MSC_VER
+        #pragma message("VIRTUAL_JOYSTICK_NO_MAIN has no effect and can be removed: the demo's main is only compiled with VIRTUAL_JOYSTICK_DEMO")
+    #else
+        #warning "VIRTUAL_JOYSTICK_NO_MAIN has no effect and can be removed: the demo's main is only compiled with VIRTUAL_JOYSTICK_DEMO"
+    #endif
+#endif
+#ifndef VIRTUAL_JOYSTICK_API
+    #ifdef VIRTUAL_JOYSTICK_STATIC
+        #define VIRTUAL_JOYSTICK_API static inline
+    #else
+        #define VIRTUAL_JOYSTICK_API extern
+    #endif
+#endif
+
 // This block ensures that the C functions are compatible with C++ compilers.
 // It prevents name mangling, allowing C++ code to link with C functions.
 #ifdef __cplusplus
@@ -48,30 +103,299 @@ static inline Vector2 Vector2_LimitLength(Vector2 v, float max_len) {
 typedef enum {
     JOYSTICK_MODE_FIXED,    // The joystick stays in its initial position.
     JOYSTICK_MODE_DYNAMIC,  // The joystick appears at the touched position.
-    JOYSTICK_MODE_FOLLOWING // The joystick follows the finger if it moves outside the clampzone.
+    JOYSTICK_MODE_FOLLOWING, // The joystick follows the finger if it moves outside the clampzone.
+    JOYSTICK_MODE_RELATIVE  // Like DYNAMIC, but the finger's motion is summed up as a delta (see VirtualJoystick_ConsumeRelativeDelta) and output stays zero.
 } JoystickMode;
 
+// --- Joystick Deadzone Enumeration ---
+// Defines how distances from the base center are turned into output.
+typedef enum {
+    JOYSTICK_DEADZONE_SCALED_RADIAL, // Zero inside a circle, then rescaled so output starts at 0 at its edge (default).
+    JOYSTICK_DEADZONE_RADIAL,        // Zero inside a circle, then the plain distance (output jumps at the edge).
+    JOYSTICK_DEADZONE_AXIAL,         // Each axis is zeroed separately while within the deadzone.
+    JOYSTICK_DEADZONE_CROSS          // Like AXIAL, but each axis is rescaled to start at 0 at the deadzone edge.
+} JoystickDeadzone;
+
+// --- Joystick Backend Enumeration ---
+// The ways joystick shapes can be put on screen. Which one is fastest depends on the renderer,
+// so each renderer is probed once and the fastest supported backend is used for it.
+// Render-target textures are never picked automatically, since their contents can be lost.
+typedef enum {
+    JOYSTICK_BACKEND_AUTO,           // Not chosen yet; the renderer is probed before its first use.
+    JOYSTICK_BACKEND_TARGET_TEXTURE, // Render-target textures (contents must be restored after SDL_RENDER_TARGETS_RESET).
+    JOYSTICK_BACKEND_STATIC_TEXTURE, // Static textures uploaded once with SDL_UpdateTexture.
+    JOYSTICK_BACKEND_GEOMETRY,       // Untextured triangle fans drawn with SDL_RenderGeometry.
+    JOYSTICK_BACKEND_SURFACE,        // Textures created from surfaces in the renderer's preferred format (blits on software renderers).
+    JOYSTICK_BACKEND_COUNT
+} JoystickBackend;
+
+// --- VirtualJoystickStats Structure ---
+// Diagnostic counters reported by VirtualJoystick_GetStats.
+typedef struct {
+    JoystickBackend backend;                   // Backend used for the queried renderer (JOYSTICK_BACKEND_AUTO if never drawn to).
+    float probe_ms[JOYSTICK_BACKEND_COUNT];    // Probe time per backend in milliseconds; 0 if unsupported or not measured.
+    bool premultiplied;                        // True if the queried renderer draws textures with premultiplied alpha.
+    int texture_count;                         // Textures currently cached for the queried renderer.
+    int texture_uploads;                       // Texture uploads on all renderers since startup.
+    int layer_redraws;                         // Controls re-rendered into HUD layers since startup.
+    int state_changes;                         // Texture and color-mod changes in the last submitted draw list.
+    float prepare_ms;                          // Wall-clock time of the last VirtualJoystick_PrepareBitmaps call.
+    int prepare_threads;                       // Threads that rasterized in the last VirtualJoystick_PrepareBitmaps call (0 if nothing was pending).
+} VirtualJoystickStats;
+
+// --- VirtualJoystickMemoryStats Structure ---
+// Memory use reported by VirtualJoystick_GetMemoryStats. Texture sizes are estimated from their
+// dimensions and pixel format; drivers may keep more.
+typedef struct {
+    size_t heap_bytes;             // Heap memory in use.
+    size_t peak_heap_bytes;        // Highest heap_bytes since startup (aggregate only).
+    int allocation_count;          // Live heap allocations.
+    size_t texture_bytes;          // Estimated memory of the textures in use.
+    int texture_count;             // Live textures (aggregate only).
+} VirtualJoystickMemoryStats;
+
+// --- VirtualJoystickBitmap Structure ---
+// A compact CPU-side copy of a rasterized control shape. Only the coverage (alpha) of each
+// pixel is stored; the color is applied when the bitmap is expanded and uploaded to a texture.
+// Skin atlas pages use the same structure with full RGBA pixels instead.
+// Keeping this around lets textures be restored after a render-target or device reset
+// without recomputing the geometry. Bitmaps are shared between joysticks with identical shapes,
+// so each renderer needs only one texture per distinct bitmap.
+typedef struct VirtualJoystickBitmap {
+    int width;                     // Width of the bitmap in pixels.
+    int height;                    // Height of the bitmap in pixels.
+    SDL_Color color;               // Color applied to every covered pixel on upload.
+    int aa_samples;                // Anti-aliasing samples per axis used to rasterize it (1 = hard edges).
+    Uint8* alpha;                  // width * height coverage values (0 = empty, 255 = fully covered).
+    Uint32* pixels;                // width * height SDL_PIXELFORMAT_RGBA8888 pixels for skin atlas pages, NULL for circles.
+    int version;                   // Increased whenever the pixels change, so textures know to re-upload.
+
+    int _refcount;                 // Number of joysticks using this bitmap (plus one while it is prepared).
+    bool _prepared;                // True while VirtualJoystick_PrepareBitmaps keeps the bitmap alive.
+    bool _mapped;                  // True if alpha points into the on-disk cache instead of owned memory.
+    struct VirtualJoystickBitmap* _next; // Next bitmap in the shared bitmap list.
+} VirtualJoystickBitmap;
+
+// --- VirtualJoystickSkin Structure ---
+// An image used instead of a generated circle for a joystick's base or tip. Skins are packed
+// into shared atlas pages and deduplicated by content, so any number of controls using the
+// same image share one texture region per renderer and are drawn from the same atlas texture.
+typedef struct VirtualJoystickSkin {
+    int width;                     // Width of the image in pixels.
+    int height;                    // Height of the image in pixels.
+    SDL_Rect src_rect;             // Region of the image inside its atlas page.
+
+    struct VirtualJoystickAtlasPage* _page; // Atlas page holding the image.
+    Uint32 _hash;                  // Content hash used for deduplication.
+    int _refcount;                 // Number of owners (the creator plus joysticks using it).
+    int _users;                    // Number of joysticks drawing the skin.
+    struct VirtualJoystickSkin* _next; // Next skin in the list of loaded skins.
+} VirtualJoystickSkin;
+
+// --- VirtualJoystickBitmapDesc Structure ---
+// Describes a circle bitmap to generate ahead of time with VirtualJoystick_PrepareBitmaps.
+typedef struct {
+    int radius;                    // Radius of the circle.
+    SDL_Color color;               // Color of the circle.
+    int aa_samples;                // Anti-aliasing samples per axis (0 or 1 = hard edges).
+} VirtualJoystickBitmapDesc;
+
+#define VIRTUAL_JOYSTICK_TOUCH_HISTORY 64 // Raw touch positions kept per joystick for the debug overlay.
+
+// --- Joystick Change Flags ---
+// What a VirtualJoystickChange reports as changed.
+typedef enum {
+    JOYSTICK_CHANGED_OUTPUT = 1 << 0,    // output moved by more than change_epsilon (or became zero / non-zero).
+    JOYSTICK_CHANGED_PRESSED = 1 << 1,   // is_pressed changed.
+    JOYSTICK_CHANGED_DIRECTION = 1 << 2  // The quantized direction changed.
+} JoystickChangeFlags;
+
+// --- Joystick Touch Phase Enumeration ---
+// The stages of a touch, as seen by the joystick core.
+typedef enum {
+    JOYSTICK_TOUCH_DOWN,           // A finger (or mouse button, or key) went down.
+    JOYSTICK_TOUCH_MOVE,           // It moved.
+    JOYSTICK_TOUCH_UP              // It was released.
+} JoystickTouchPhase;
+
+// --- VirtualJoystickTouchSample Structure ---
+// One touch sample in window pixels. Every input source (touch, mouse, keyboard, custom sources
+// and injected input) is converted into these before it reaches the joystick core.
+typedef struct {
+    JoystickTouchPhase phase;      // Stage of the touch.
+    SDL_FingerID finger_id;        // Identifies the touch across samples (see VIRTUAL_JOYSTICK_MOUSE_FINGER and friends).
+    float x;                       // Position in window pixels.
+    float y;
+    Uint32 timestamp;              // Time in milliseconds (SDL_GetTicks time base).
+} VirtualJoystickTouchSample;
+
+// --- Joystick Input Source Flags ---
+// The input sources a joystick listens to (VirtualJoystick.input_sources).
+typedef enum {
+    JOYSTICK_INPUT_TOUCH = 1 << 0,     // SDL_FINGER* events.
+    JOYSTICK_INPUT_MOUSE = 1 << 1,     // Dragging with the left mouse button (touch-generated mouse events are ignored).
+    JOYSTICK_INPUT_KEYBOARD = 1 << 2,  // WASD and arrow keys push the stick to its clampzone edge.
+    JOYSTICK_INPUT_CUSTOM = 1 << 3     // Sources registered with VirtualJoystick_SetInputSource.
+} JoystickInputSource;
+
+#define VIRTUAL_JOYSTICK_MOUSE_FINGER ((SDL_FingerID)-2)    // finger_id of samples from the mouse.
+#define VIRTUAL_JOYSTICK_KEYBOARD_FINGER ((SDL_FingerID)-3) // finger_id of samples from the keyboard.
+#define VIRTUAL_JOYSTICK_INJECTED_FINGER ((SDL_FingerID)-4) // Finger that holds joysticks driven by VirtualJoystick_InjectOutputs.
+#define VIRTUAL_JOYSTICK_MAX_SOURCE_SAMPLES 2               // Most samples an input source may produce per event.
+
+struct VirtualJoystick;
+
+// Converts an SDL event into up to VIRTUAL_JOYSTICK_MAX_SOURCE_SAMPLES touch samples for a joystick
+// and returns how many it wrote.
+typedef int (*VirtualJoystickInputSource)(struct VirtualJoystick* joystick, const SDL_Event* event, VirtualJoystickTouchSample* samples);
+
+// --- VirtualJoystickChange Structure ---
+// A change record describing a joystick's state after it changed.
+typedef struct {
+    struct VirtualJoystick* joystick; // The joystick that changed.
+    Uint32 flags;                  // JoystickChangeFlags that changed (combined if several changes were queued).
+    Vector2 output;                // output at the time of the change.
+    bool is_pressed;               // is_pressed at the time of the change.
+    int direction;                 // Quantized direction (0 = right, counting clockwise on screen), or -1 if output is zero.
+} VirtualJoystickChange;
+
+// Called with each change record of a joystick that has a change_callback.
+typedef void (*VirtualJoystickChangeCallback)(const VirtualJoystickChange* change, void* userdata);
+
+#define VIRTUAL_JOYSTICK_SHARED_MAGIC 0x4B534A56u // "VJSK" in memory on little-endian machines.
+#define VIRTUAL_JOYSTICK_SHARED_VERSION 1         // Bumped whenever the shared region layout changes.
+#define VIRTUAL_JOYSTICK_SHARED_RING 256          // Recent samples kept in a shared region.
+#define VIRTUAL_JOYSTICK_SHARED_MAX_RETRIES 100000 // Reads give up after this many attempts (e.g. the writer died mid-update).
+
+// --- Joystick Shared Sample Flags ---
+typedef enum {
+    JOYSTICK_SHARED_PRESSED = 1 << 0, // is_pressed was set.
+    JOYSTICK_SHARED_ACTIVE = 1 << 1,  // A finger was tracking the joystick.
+    JOYSTICK_SHARED_VISIBLE = 1 << 2  // The joystick was shown.
+} JoystickSharedFlags;
+
+// --- VirtualJoystickSharedSample Structure ---
+// A snapshot of a joystick's state as published to shared memory. Only fixed-size types are used
+// so readers built by other compilers see the same layout.
+typedef struct {
+    Uint32 timestamp;              // SDL_GetTicks() when the snapshot was taken.
+    Uint32 flags;                  // JoystickSharedFlags.
+    float output_x, output_y;      // output.
+    float base_x, base_y;          // Base center in window pixels.
+    float tip_x, tip_y;            // Tip center in window pixels.
+} VirtualJoystickSharedSample;
+
+// --- VirtualJoystickSharedRegion Structure ---
+// Layout of the POSIX shared memory object a joystick publishes to (VirtualJoystick_PublishShared).
+// The single writer updates it under a seqlock: sequence is odd while a write is in progress, so
+// readers copy what they need and retry if sequence was odd or changed meanwhile. Readers never
+// write to the region and never block the writer.
+typedef struct {
+    Uint32 magic;                  // VIRTUAL_JOYSTICK_SHARED_MAGIC.
+    Uint32 version;                // VIRTUAL_JOYSTICK_SHARED_VERSION.
+    Uint32 ring_length;            // VIRTUAL_JOYSTICK_SHARED_RING.
+    Uint32 reserved;
+    volatile Uint32 sequence;      // Seqlock counter.
+    volatile Uint32 write_count;   // Samples written so far; the newest is ring[(write_count - 1) % ring_length].
+    VirtualJoystickSharedSample current; // The latest snapshot.
+    VirtualJoystickSharedSample ring[VIRTUAL_JOYSTICK_SHARED_RING]; // Recent snapshots, oldest overwritten first.
+} VirtualJoystickSharedRegion;
+
+// Reads the latest snapshot from a shared region (for example one mapped by another process).
+// Returns: false if the region is not a compatible joystick region, or if no consistent snapshot
+//          could be read within VIRTUAL_JOYSTICK_SHARED_MAX_RETRIES attempts (the writer died
+//          in the middle of an update).
+static inline bool VirtualJoystickShared_ReadCurrent(const VirtualJoystickSharedRegion* region, VirtualJoystickSharedSample* sample) {
+    if (region->magic != VIRTUAL_JOYSTICK_SHARED_MAGIC || region->version != VIRTUAL_JOYSTICK_SHARED_VERSION) return false;
+    for (int attempt = 0; attempt < VIRTUAL_JOYSTICK_SHARED_MAX_RETRIES; attempt++) {
+        Uint32 before = region->sequence;
+        SDL_MemoryBarrierAcquire();
+        *sample = region->current;
+        SDL_MemoryBarrierAcquire();
+        Uint32 after = region->sequence;
+        if (!(before & 1) && before == after) return true;
+    }
+    return false;
+}
+
+// Reads the snapshots written since *cursor (a write count, start with 0) and advances *cursor.
+// If the reader fell more than a ring behind, the overwritten snapshots are skipped. If the
+// publisher restarted (write_count went back below *cursor), reading starts over from its first
+// snapshot; a restart that has already written past *cursor cannot be told apart from new samples.
+// Returns: The number of snapshots copied into samples (at most max_samples), 0 if no consistent
+//          copy could be made within VIRTUAL_JOYSTICK_SHARED_MAX_RETRIES attempts (the writer died
+//          in the middle of an update; *cursor is left alone), or -1 if the region is not a
+//          compatible joystick region.
+static inline int VirtualJoystickShared_ReadRecent(const VirtualJoystickSharedRegion* region, Uint32* cursor,
+                                                   VirtualJoystickSharedSample* samples, int max_samples) {
+    if (region->magic != VIRTUAL_JOYSTICK_SHARED_MAGIC || region->version != VIRTUAL_JOYSTICK_SHARED_VERSION) return -1;
+    for (int attempt = 0; attempt < VIRTUAL_JOYSTICK_SHARED_MAX_RETRIES; attempt++) {
+        Uint32 before = region->sequence;
+        SDL_MemoryBarrierAcquire();
+        Uint32 written = region->write_count;
+        Uint32 start = *cursor;
+        if (written < start) start = 0; // The publisher restarted.
+        if (written - start > VIRTUAL_JOYSTICK_SHARED_RING) start = written - VIRTUAL_JOYSTICK_SHARED_RING;
+        int count = (int)(written - start) < max_samples ? (int)(written - start) : max_samples;
+        for (int i = 0; i < count; i++) {
+            samples[i] = region->ring[(start + (Uint32)i) % VIRTUAL_JOYSTICK_SHARED_RING];
+        }
+        SDL_MemoryBarrierAcquire();
+        Uint32 after = region->sequence;
+        if (!(before & 1) && before == after) {
+            *cursor = start + (Uint32)count;
+            return count;
+        }
+    }
+    return 0;
+}
+
 // --- VirtualJoystick Structure ---
 // Represents the state and properties of the virtual joystick.
-typedef struct {
+typedef struct VirtualJoystick {
     SDL_Renderer* renderer;        // SDL renderer used for drawing.
     SDL_Rect joystick_area;        // The overall rectangular area on screen where the joystick operates.
 
     SDL_Color pressed_color;       // Color of the tip when the joystick is pressed.
     float deadzone_size;           // Input inside this range yields zero output.
     float clampzone_size;          // Maximum distance the tip can move from the base center.
-    JoystickMode joystick_mode;    // Current mode of the joystick (FIXED, DYNAMIC, FOLLOWING).
+    JoystickDeadzone deadzone_shape; // How deadzone_size is applied (SCALED_RADIAL by default).
+    float outer_deadzone_size;     // Output is already full this many pixels before the clampzone edge.
+    float snap_angle;              // Output within this many degrees of an axis is snapped onto it (0 = off).
+    float relative_sensitivity;    // RELATIVE mode: delta units per pixel of finger motion.
+    float relative_acceleration;   // RELATIVE mode: extra gain per pixel/millisecond of finger speed (0 = linear).
+    float return_spring_frequency; // Hz of the spring pulling the tip back to the base on release (0 = snap back instantly).
+    float follow_spring_frequency; // Hz of the spring pulling the base after the finger in FOLLOWING mode (0 = jump).
+
+    float change_epsilon;          // Output changes smaller than this are not reported as changes.
+    int direction_count;           // Number of directions output is quantized to for change records (0 = no direction).
+    VirtualJoystickChangeCallback change_callback; // Receives change records if set.
+    void* change_userdata;         // Passed to change_callback.
+    bool queue_changes;            // Without a callback, queue change records for VirtualJoystick_PollChanges.
+    Uint32 input_sources;          // JoystickInputSource flags of the inputs the joystick reacts to (touch and custom by default).
+    JoystickMode joystick_mode;    // Current mode of the joystick (FIXED, DYNAMIC, FOLLOWING, RELATIVE).
+    int z_order;                   // Draw lists draw lower values first; controls with equal values may be batched together.
+    bool debug_overlay;            // If true, Draw also shows the area, zones, snapping, touch path and output vector.
 
     bool is_pressed;               // True if the joystick is currently being pressed.
     Vector2 output;                // The normalized output vector (from -1 to 1 in X and Y).
 
-    int _touch_index;              // The ID of the finger currently interacting with the joystick (-1 if none).
+    SDL_FingerID _touch_index;     // The ID of the finger currently interacting with the joystick (-1 if none).
+    Uint8 _pressed_keys;           // Keyboard source: bit mask of the held direction keys (up, left, down, right).
 
-    SDL_Texture* _base_texture;    // Texture for the joystick's base.
-    SDL_Texture* _tip_texture;     // Texture for the joystick's movable tip.
+    VirtualJoystickBitmap* _base_bitmap; // Shared bitmap of the joystick's base; textures are looked up per renderer.
+    VirtualJoystickBitmap* _tip_bitmap;  // Shared bitmap of the joystick's movable tip.
+    VirtualJoystickSkin* _base_skin;     // Image drawn instead of _base_bitmap, or NULL.
+    VirtualJoystickSkin* _tip_skin;      // Image drawn instead of _tip_bitmap, or NULL.
 
     SDL_FPoint _base_center;       // Current center position of the base on screen.
     SDL_FPoint _tip_center;        // Current center position of the tip on screen.
+    SDL_FPoint _base_draw_center;  // Where the base is drawn; trails _base_center while its spring animates.
+    SDL_FPoint _tip_draw_center;   // Where the tip is drawn; trails _tip_center while its spring animates.
+    Vector2 _base_velocity;        // Velocity of the base's spring in pixels per second.
+    Vector2 _tip_velocity;         // Velocity of the tip's spring in pixels per second.
+    bool _base_following;          // True while the base springs after the finger.
+    bool _returning;               // True while the tip springs back after release (the joystick hides when it settles).
 
     SDL_FPoint _base_default_center; // Initial (default) center position of the base.
 
@@ -82,331 +406,4310 @@ typedef struct {
     bool _hidden;                  // If true, the joystick is not drawn or processed.
     int _window_width;             // Stored window width for touch coordinate conversion.
     int _window_height;            // Stored window height for touch coordinate conversion.
+    float _snap_tangent;           // tan(snap_angle), recomputed only when snap_angle changes.
+    float _snap_tangent_angle;     // snap_angle that _snap_tangent was computed for.
+
+    SDL_FPoint _touch_history[VIRTUAL_JOYSTICK_TOUCH_HISTORY]; // Ring buffer of raw touch positions (only recorded with debug_overlay).
+    int _touch_history_start;      // Index of the oldest position in _touch_history.
+    int _touch_history_count;      // Number of positions in _touch_history.
+
+    Vector2 _relative_delta;       // RELATIVE mode: motion summed up since the last consume.
+    SDL_FPoint _last_touch_position; // RELATIVE mode: finger position at the previous event.
+    Uint32 _last_touch_timestamp;  // RELATIVE mode: timestamp of the previous event.
+
+    Vector2 _reported_output;      // output in the last change record.
+    bool _reported_pressed;        // is_pressed in the last change record.
+    int _reported_direction;       // Direction in the last change record.
+    int _queued_change;            // Index of the joystick's pending record in the change queue, or -1.
+
+    SDL_Joystick* _device;         // Attached SDL virtual joystick device, or NULL.
+    int _device_axis;              // Controller axis receiving output.x (output.y goes to the next axis).
+    Sint16 _device_axes[2];        // Axis values last pushed to the device.
+    bool _device_button;           // Stick button state last pushed to the device.
+
+    VirtualJoystickSharedRegion* _shared; // Shared memory region the state is published to, or NULL.
+    char* _shared_name;            // Name of the shared memory object, for unlinking it.
 } VirtualJoystick;
 
+#define VIRTUAL_JOYSTICK_GROUP_STICKS 4   // Sticks a VirtualJoystickGroup can hold.
+#define VIRTUAL_JOYSTICK_GROUP_FINGERS 10 // Fingers a VirtualJoystickGroup tracks at once.
+#define VIRTUAL_JOYSTICK_GESTURE_STICK -2 // VirtualJoystickGroupFinger.stick of the fingers driving the group's gesture.
+
+// --- VirtualJoystickGroupFinger Structure ---
+// A finger that touched down inside a VirtualJoystickGroup's area and has not been lifted yet.
+typedef struct {
+    SDL_FingerID finger_id;        // The finger (or VIRTUAL_JOYSTICK_MOUSE_FINGER for the mouse).
+    SDL_FPoint position;           // Latest position in window pixels.
+    int stick;                     // Index of the stick the finger drives, VIRTUAL_JOYSTICK_GESTURE_STICK, or -1 if it drives nothing.
+} VirtualJoystickGroupFinger;
+
+// --- VirtualJoystickGesture Structure ---
+// A two-finger gesture (pinch, rotate and pan) recognized over a VirtualJoystickGroup's fingers.
+// It starts when a second finger touches down in its area while another finger in the area
+// drives nothing, or lands on the area of a stick whose finger has not pressed it yet (still
+// inside the deadzone). The new finger is checked before it is given a stick, so no stick has
+// to be stolen for this. With steal_sticks, a finger landing on the area of a pressed stick
+// pairs with that stick's finger as well. Either way the partner's stick is released and both
+// fingers drive the gesture. The results are measured from where the fingers were when the
+// gesture started and are updated in constant time on every motion.
+typedef struct {
+    SDL_Rect area;                 // Region (window pixels) both fingers must touch down in.
+    bool steal_sticks;             // If true, a second finger on the area of a pressed stick turns its finger into a gesture.
+
+    bool active;                   // True while two fingers drive the gesture.
+    SDL_FPoint centroid;           // Midpoint between the two fingers.
+    Vector2 pan;                   // Movement of the midpoint since the gesture started (two-finger pan).
+    float scale;                   // Finger distance relative to the start (pinch: > 1 apart, < 1 together).
+    float rotation;                // Rotation since the start in radians, positive clockwise on screen (not wrapped).
+
+    SDL_FingerID _finger_ids[2];   // The two fingers.
+    SDL_FPoint _positions[2];      // Latest position of each finger.
+    SDL_FPoint _start_centroid;    // centroid when the gesture started.
+    float _start_distance;         // Finger distance when the gesture started.
+    float _last_angle;             // Angle of the line between the fingers at the last update.
+} VirtualJoystickGesture;
+
+// --- VirtualJoystickGroup Structure ---
+// One touch area shared by several sticks, e.g. a twin-stick layout covering the whole screen.
+// Each finger touching down is given to the free stick nearest to it: a stick whose own
+// joystick_area contains the finger wins, otherwise the one whose area is closest. So the first
+// finger on the left takes the move stick, the first on the right the aim stick, and later
+// fingers the nearest stick still free. Motion and release are routed through the group's finger
+// table, so the sticks never test their areas themselves; pass input to
+// VirtualJoystickGroup_HandleEvent instead of the sticks' VirtualJoystick_HandleEvent.
+// A VirtualJoystickGesture can share the same fingers (see VirtualJoystickGroup_SetGesture).
+typedef struct {
+    SDL_Rect area;                 // Shared touch area in window pixels.
+    Uint32 input_sources;          // JoystickInputSource flags routed to the sticks (keyboard input stays per stick).
+
+    int _window_width;             // Window size, for converting normalized touch coordinates.
+    int _window_height;
+    VirtualJoystickGesture* _gesture; // Gesture recognized over the group's fingers, or NULL.
+
+    VirtualJoystick* _sticks[VIRTUAL_JOYSTICK_GROUP_STICKS]; // The sticks, in the order they were added.
+    int _stick_count;              // Number of sticks.
+    VirtualJoystickGroupFinger _fingers[VIRTUAL_JOYSTICK_GROUP_FINGERS]; // Fingers down in the area.
+    int _finger_count;             // Number of fingers in _fingers.
+} VirtualJoystickGroup;
+
+// --- VirtualJoystickAim Structure ---
+// Fuses gyro aiming with a stick into one aim vector, as mobile shooters do. Gyro rates from
+// SDL_SENSORUPDATE (the device gyro) or SDL_CONTROLLERSENSORUPDATE events are corrected by a
+// bias estimate, integrated over the time between samples and summed until the next
+// VirtualJoystickAim_Consume, which adds the stick's contribution for the frame. The bias estimate
+// follows the gyro while it reads nearly constant rates, which is what a still device reports,
+// so drift is removed without a calibration step.
+typedef struct {
+    VirtualJoystick* stick;        // Stick blended into the aim, or NULL for gyro only.
+    float stick_speed;             // Aim units per second at full stick deflection.
+    Vector2 gyro_sensitivity;      // Aim units per radian turned (x: yaw, y: pitch); negative values invert an axis.
+    int yaw_axis;                  // Gyro axis (0 = x, 1 = y, 2 = z) that turns the aim horizontally.
+    int pitch_axis;                // Gyro axis that turns the aim vertically.
+    float bias_threshold;          // Rates (rad/s) within this of the bias estimate count as holding still.
+    float bias_settle_time;        // Seconds the gyro must hold still before the bias estimate follows it.
+    float bias_time_constant;      // Time constant (seconds) of the bias estimate while still (0 = no compensation).
+    SDL_SensorID gyro_sensor;      // Device gyro whose SDL_SENSORUPDATE events are used (-1 = none).
+    bool use_controllers;          // If true and gyro_sensor is -1, a game controller's gyro (SDL_CONTROLLERSENSORUPDATE) is used.
+    SDL_JoystickID controller_id;  // Controller whose gyro is used (-1 = the first one that sends gyro events).
+
+    float bias[3];                 // Current bias estimate per gyro axis in rad/s.
+
+    Vector2 _gyro_aim;             // Gyro aim summed since the last VirtualJoystickAim_Consume.
+    Uint64 _last_timestamp;        // Timestamp of the previous gyro sample in microseconds.
+    bool _has_sample;              // True once a gyro sample was seen (the first one has no duration).
+    float _still_time;             // Seconds the gyro has been holding still.
+    SDL_Sensor* _sensor;           // Gyro opened by VirtualJoystickAim_OpenGyro, or NULL.
+} VirtualJoystickAim;
+
+// --- VirtualJoystickHUDEntry Structure ---
+// What a VirtualJoystickHUD last composited for one control, used to detect changes.
+typedef struct {
+    VirtualJoystick* joystick;     // The control.
+    bool in_layer;                 // True if the control is currently rendered into the cached layer.
+    bool hidden;                   // Visibility at the last composite.
+    bool active;                   // True if a finger was tracking the control at the last composite.
+    SDL_Rect base_rect;            // Base destination rectangle at the last composite.
+    SDL_Rect tip_rect;             // Tip destination rectangle at the last composite.
+    SDL_Color tip_color;           // Tip color at the last composite.
+    const VirtualJoystickBitmap* base_bitmap; // Bitmap the base was drawn from (a circle, or a skin's page).
+    const VirtualJoystickBitmap* tip_bitmap;  // Bitmap the tip was drawn from.
+    const SDL_Rect* base_src;      // Skin region the base was drawn from, or NULL for a circle.
+    const SDL_Rect* tip_src;       // Skin region the tip was drawn from, or NULL for a circle.
+} VirtualJoystickHUDEntry;
+
+// --- VirtualJoystickHUD Structure ---
+// An optional compositor for HUDs with many mostly-idle controls. Idle controls are rendered
+// into one cached target texture, and only controls that changed are re-rendered into it.
+// Controls a finger is tracking are drawn directly on top every frame. When nothing changes,
+// drawing the HUD costs a single SDL_RenderCopy.
+typedef struct {
+    SDL_Renderer* renderer;        // Renderer the HUD layer is created on and drawn to.
+    int width;                     // Width of the HUD layer (normally the window width).
+    int height;                    // Height of the HUD layer (normally the window height).
+
+    SDL_Texture* _layer;           // Cached layer with the idle controls (NULL without render targets or a premultiplied blend mode).
+    VirtualJoystickHUDEntry* _entries; // The controls in the HUD, in drawing order.
+    int _count;                    // Number of controls in the HUD.
+    int _capacity;                 // Allocated length of _entries.
+    bool _full_redraw;             // True if the whole layer must be re-rendered on the next draw.
+    int _reset_generation;         // Value of the renderer reset counter the layer was last rendered at.
+} VirtualJoystickHUD;
+
+// --- VirtualJoystickDrawCommand Structure ---
+// One bitmap draw collected by a VirtualJoystickDrawList.
+typedef struct {
+    const VirtualJoystickBitmap* bitmap; // The bitmap to draw.
+    SDL_Rect src_rect;             // Part of the bitmap to draw (the whole bitmap for circles).
+    SDL_Rect dst_rect;             // Where to draw it on screen.
+    SDL_Color color_mod;           // Color modulation to draw it with.
+    int z_order;                   // z_order of the control the command belongs to.
+    int layer;                     // Layer within the control (0 = base, 1 = tip).
+    int sequence;                  // Order the command was added in, to keep sorting deterministic.
+} VirtualJoystickDrawCommand;
+
+// --- VirtualJoystickDrawList Structure ---
+// Collects draw commands from many controls and submits them sorted by z_order, layer, bitmap
+// and color, so consecutive draws share the same texture and color modulation. All bases of one
+// z_order are drawn before its tips; give overlapping controls different z_order values to keep
+// them apart.
+typedef struct {
+    VirtualJoystickDrawCommand* _commands; // Collected commands.
+    int _count;                    // Number of collected commands.
+    int _capacity;                 // Allocated length of _commands.
+    int state_changes;             // Texture and color-mod changes made by the last submit.
+} VirtualJoystickDrawList;
+
 // --- Function Prototypes (Public API) ---
 // These functions are the main interface for interacting with the VirtualJoystick.
-VirtualJoystick* VirtualJoystick_Create(SDL_Renderer* renderer, int x, int y, int width, int height, int window_width, int window_height);
-void VirtualJoystick_Destroy(VirtualJoystick* joystick);
-void VirtualJoystick_SetWindowSize(VirtualJoystick* joystick, int width, int height);
-void VirtualJoystick_HandleEvent(VirtualJoystick* joystick, const SDL_Event* event);
-void VirtualJoystick_Draw(VirtualJoystick* joystick, SDL_Renderer* renderer);
+VIRTUAL_JOYSTICK_API VirtualJoystick* VirtualJoystick_Create(SDL_Renderer* renderer, int x, int y, int width, int height, int window_width, int window_height);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_Destroy(VirtualJoystick* joystick);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_SetWindowSize(VirtualJoystick* joystick, int width, int height);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_HandleEvent(VirtualJoystick* joystick, const SDL_Event* event);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_Draw(VirtualJoystick* joystick, SDL_Renderer* renderer);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_DrawDebugOverlay(const VirtualJoystick* joystick, SDL_Renderer* renderer);
+VIRTUAL_JOYSTICK_API Vector2 VirtualJoystick_ConsumeRelativeDelta(VirtualJoystick* joystick);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_Update(VirtualJoystick* joystick, float dt);
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_IsActive(const VirtualJoystick* joystick);
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_IsAnimating(const VirtualJoystick* joystick);
+VIRTUAL_JOYSTICK_API int VirtualJoystick_GetUpdateTimeout(VirtualJoystick* const* joysticks, int count);
+VIRTUAL_JOYSTICK_API int VirtualJoystick_PollChanges(VirtualJoystickChange* changes, int max_changes);
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_AttachDevice(VirtualJoystick* joystick, SDL_GameControllerAxis x_axis);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_SetInputSource(Uint32 event_type, VirtualJoystickInputSource source);
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_PublishShared(VirtualJoystick* joystick, const char* name);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_UnpublishShared(VirtualJoystick* joystick);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_InjectSample(VirtualJoystick* joystick, const VirtualJoystickTouchSample* sample);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_InjectSamples(VirtualJoystick* joystick, const VirtualJoystickTouchSample* samples, int count);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_InjectOutputs(VirtualJoystick* const* joysticks, const Vector2* outputs, int count);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_DetachDevice(VirtualJoystick* joystick);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_ReleaseRenderer(SDL_Renderer* renderer);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_SetRendererBackend(SDL_Renderer* renderer, JoystickBackend backend);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_GetStats(SDL_Renderer* renderer, VirtualJoystickStats* stats);
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_SetAllocator(SDL_malloc_func malloc_func, SDL_calloc_func calloc_func, SDL_realloc_func realloc_func, SDL_free_func free_func);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_GetMemoryStats(const VirtualJoystick* joystick, VirtualJoystickMemoryStats* stats);
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_StartTrace(void);
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_WriteTrace(const char* path);
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_PrepareBitmaps(SDL_Renderer* renderer, const VirtualJoystickBitmapDesc* descs, int count, int thread_count);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_ReleasePreparedBitmaps(void);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_SetAntialiasing(int samples);
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_OpenBitmapCache(const char* path);
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_SaveBitmapCache(const char* path);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_CloseBitmapCache(void);
+
+VIRTUAL_JOYSTICK_API VirtualJoystickSkin* VirtualJoystickSkin_LoadBMP(const char* path);
+VIRTUAL_JOYSTICK_API VirtualJoystickSkin* VirtualJoystickSkin_CreateFromRGBA(const Uint8* rgba, int width, int height, int pitch);
+VIRTUAL_JOYSTICK_API void VirtualJoystickSkin_Release(VirtualJoystickSkin* skin);
+VIRTUAL_JOYSTICK_API void VirtualJoystick_SetSkin(VirtualJoystick* joystick, VirtualJoystickSkin* base_skin, VirtualJoystickSkin* tip_skin);
+
+VIRTUAL_JOYSTICK_API VirtualJoystickGroup* VirtualJoystickGroup_Create(int x, int y, int width, int height, int window_width, int window_height);
+VIRTUAL_JOYSTICK_API void VirtualJoystickGroup_Destroy(VirtualJoystickGroup* group);
+VIRTUAL_JOYSTICK_API bool VirtualJoystickGroup_AddStick(VirtualJoystickGroup* group, VirtualJoystick* joystick);
+VIRTUAL_JOYSTICK_API void VirtualJoystickGroup_RemoveStick(VirtualJoystickGroup* group, VirtualJoystick* joystick);
+VIRTUAL_JOYSTICK_API void VirtualJoystickGroup_HandleEvent(VirtualJoystickGroup* group, const SDL_Event* event);
+VIRTUAL_JOYSTICK_API void VirtualJoystickGroup_InjectSample(VirtualJoystickGroup* group, const VirtualJoystickTouchSample* sample);
+VIRTUAL_JOYSTICK_API void VirtualJoystickGroup_SetWindowSize(VirtualJoystickGroup* group, int window_width, int window_height);
+VIRTUAL_JOYSTICK_API void VirtualJoystickGroup_SetGesture(VirtualJoystickGroup* group, VirtualJoystickGesture* gesture);
+
+VIRTUAL_JOYSTICK_API VirtualJoystickGesture* VirtualJoystickGesture_Create(int x, int y, int width, int height);
+VIRTUAL_JOYSTICK_API void VirtualJoystickGesture_Destroy(VirtualJoystickGesture* gesture);
+
+VIRTUAL_JOYSTICK_API VirtualJoystickAim* VirtualJoystickAim_Create(VirtualJoystick* stick);
+VIRTUAL_JOYSTICK_API void VirtualJoystickAim_Destroy(VirtualJoystickAim* aim);
+VIRTUAL_JOYSTICK_API bool VirtualJoystickAim_OpenGyro(VirtualJoystickAim* aim);
+VIRTUAL_JOYSTICK_API void VirtualJoystickAim_HandleEvent(VirtualJoystickAim* aim, const SDL_Event* event);
+VIRTUAL_JOYSTICK_API void VirtualJoystickAim_InjectGyro(VirtualJoystickAim* aim, const float rates[3], Uint32 timestamp);
+VIRTUAL_JOYSTICK_API Vector2 VirtualJoystickAim_Consume(VirtualJoystickAim* aim, float dt);
+
+VIRTUAL_JOYSTICK_API VirtualJoystickHUD* VirtualJoystickHUD_Create(SDL_Renderer* renderer, int width, int height);
+VIRTUAL_JOYSTICK_API void VirtualJoystickHUD_Destroy(VirtualJoystickHUD* hud);
+VIRTUAL_JOYSTICK_API bool VirtualJoystickHUD_AddControl(VirtualJoystickHUD* hud, VirtualJoystick* joystick);
+VIRTUAL_JOYSTICK_API void VirtualJoystickHUD_RemoveControl(VirtualJoystickHUD* hud, VirtualJoystick* joystick);
+VIRTUAL_JOYSTICK_API void VirtualJoystickHUD_SetSize(VirtualJoystickHUD* hud, int width, int height);
+VIRTUAL_JOYSTICK_API void VirtualJoystickHUD_Draw(VirtualJoystickHUD* hud);
+
+VIRTUAL_JOYSTICK_API VirtualJoystickDrawList* VirtualJoystickDrawList_Create(void);
+VIRTUAL_JOYSTICK_API void VirtualJoystickDrawList_Destroy(VirtualJoystickDrawList* list);
+VIRTUAL_JOYSTICK_API void VirtualJoystickDrawList_Clear(VirtualJoystickDrawList* list);
+VIRTUAL_JOYSTICK_API bool VirtualJoystickDrawList_AddControl(VirtualJoystickDrawList* list, const VirtualJoystick* joystick);
+VIRTUAL_JOYSTICK_API void VirtualJoystickDrawList_Submit(VirtualJoystickDrawList* list, SDL_Renderer* renderer);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // VIRTUAL_JOYSTICK_H
+
+
+// --- Implementation Block ---
+// This block contains the actual definitions of the functions. It sits outside the include
+// guard so a file may include the header for its declarations first and again later with
+// VIRTUAL_JOYSTICK_IMPLEMENTATION defined; it is compiled at most once per file.
+#if (defined(VIRTUAL_JOYSTICK_IMPLEMENTATION) || defined(VIRTUAL_JOYSTICK_STATIC) || defined(VIRTUAL_JOYSTICK_DEMO)) && \
+    !defined(VIRTUAL_JOYSTICK_IMPLEMENTATION_INCLUDED)
+#define VIRTUAL_JOYSTICK_IMPLEMENTATION_INCLUDED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SDL_RenderGeometry only exists in SDL 2.0.18 and later.
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    #define VIRTUAL_JOYSTICK_HAS_GEOMETRY 1
+#else
+    #define VIRTUAL_JOYSTICK_HAS_GEOMETRY 0
+#endif
+
+// SDL virtual joystick devices (SDL_JoystickAttachVirtual) exist since SDL 2.0.14, but virtual
+// game controllers only get SDL's automatic controller mapping since SDL 2.24. Without it the
+// device is a plain joystick and the SDL_CONTROLLER_AXIS_*/BUTTON_* indices mean nothing.
+#if SDL_VERSION_ATLEAST(2, 24, 0)
+    #define VIRTUAL_JOYSTICK_HAS_VIRTUAL_DEVICE 1
+#else
+    #define VIRTUAL_JOYSTICK_HAS_VIRTUAL_DEVICE 0
+#endif
+
+// Game controller sensor events (SDL_CONTROLLERSENSORUPDATE) exist since SDL 2.0.14.
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+    #define VIRTUAL_JOYSTICK_HAS_CONTROLLER_SENSORS 1
+#else
+    #define VIRTUAL_JOYSTICK_HAS_CONTROLLER_SENSORS 0
+#endif
+
+// Sensor events carry the driver's timestamp in microseconds (timestamp_us) since SDL 2.26.
+#if SDL_VERSION_ATLEAST(2, 26, 0)
+    #define VIRTUAL_JOYSTICK_HAS_SENSOR_TIMESTAMP_US 1
+    // Drivers without their own timestamps leave timestamp_us at 0; fall back to milliseconds.
+    #define VIRTUAL_JOYSTICK_SENSOR_TIME_US(sensor_event) \
+        ((sensor_event).timestamp_us ? (sensor_event).timestamp_us : (Uint64)(sensor_event).timestamp * 1000)
+#else
+    #define VIRTUAL_JOYSTICK_HAS_SENSOR_TIMESTAMP_US 0
+    #define VIRTUAL_JOYSTICK_SENSOR_TIME_US(sensor_event) ((Uint64)(sensor_event).timestamp * 1000)
+#endif
+
+#define VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS 32 // Triangles per circle in the geometry backend.
+#define VIRTUAL_JOYSTICK_PROBE_DRAWS 64     // Draws timed per backend and round when probing a renderer.
+#define VIRTUAL_JOYSTICK_PROBE_ROUNDS 5     // Rounds per backend; the fastest round counts.
+#define VIRTUAL_JOYSTICK_PROBE_MARGIN 0.8f  // Another backend must take less than this share of the default's time to replace it.
+#define VIRTUAL_JOYSTICK_MAX_AA_SAMPLES 16  // Upper limit for anti-aliasing samples per axis.
+#define VIRTUAL_JOYSTICK_DEBUG_LINE_WIDTH 2.0f // Thickness of the debug overlay's rings and lines.
+#define VIRTUAL_JOYSTICK_SPRING_REST_DISTANCE 0.25f // Springs closer than this (pixels) to their target...
+#define VIRTUAL_JOYSTICK_SPRING_REST_SPEED 5.0f     // ...and slower than this (pixels per second) come to rest.
+#define VIRTUAL_JOYSTICK_MIN_ANIMATION_STEP_MS 4    // Shortest animation step GetUpdateTimeout reports (about 240 fps).
+#define VIRTUAL_JOYSTICK_MAX_ANIMATION_STEP_MS 33   // Longest sleep GetUpdateTimeout allows while something animates (about 30 fps).
+
+#define VIRTUAL_JOYSTICK_CACHE_MAGIC "VJBITMAP"  // First bytes of an on-disk bitmap cache file.
+#define VIRTUAL_JOYSTICK_CACHE_VERSION 1         // Bumped whenever the file layout or rasterization changes.
+#define VIRTUAL_JOYSTICK_CACHE_BYTE_ORDER 0x01020304u // Written natively; a mismatch means another byte order.
+
+// --- VirtualJoystickCacheHeader Structure ---
+// Start of an on-disk bitmap cache file. It is followed by entry_count entries and then the
+// alpha data. All values are stored in native byte order and 4-byte aligned so the file can be
+// memory-mapped and read in place.
+typedef struct {
+    char magic[8];                 // VIRTUAL_JOYSTICK_CACHE_MAGIC (not NUL-terminated).
+    Uint32 version;                // VIRTUAL_JOYSTICK_CACHE_VERSION.
+    Uint32 byte_order;             // VIRTUAL_JOYSTICK_CACHE_BYTE_ORDER.
+    Uint32 entry_count;            // Number of VirtualJoystickCacheEntry records.
+    Uint32 reserved;               // Zero.
+} VirtualJoystickCacheHeader;
+
+// --- VirtualJoystickCacheEntry Structure ---
+// One bitmap in an on-disk cache file, keyed by radius, color and anti-aliasing samples.
+typedef struct {
+    Sint32 radius;                 // Circle radius (the bitmap is radius * 2 pixels square).
+    Uint8 color[4];                // Circle color as r, g, b, a.
+    Sint32 aa_samples;             // Anti-aliasing samples per axis.
+    Uint32 offset;                 // Byte offset of the alpha data from the start of the file.
+} VirtualJoystickCacheEntry;
+
+// --- VirtualJoystickBitmapCache Structure ---
+// The on-disk cache opened by VirtualJoystick_OpenBitmapCache.
+typedef struct {
+    const Uint8* data;             // The whole file, mapped or read into memory.
+    size_t size;                   // Size of the file in bytes.
+    bool mapped;                   // True if data was memory-mapped, false if it was read into a malloc'ed buffer.
+    const VirtualJoystickCacheEntry* entries; // Entry table inside data.
+    Uint32 entry_count;            // Number of entries.
+} VirtualJoystickBitmapCache;
+
+// --- VirtualJoystickTextureEntry Structure ---
+// A texture created from a bitmap on one renderer.
+typedef struct VirtualJoystickTextureEntry {
+    const VirtualJoystickBitmap* bitmap;    // Bitmap the texture was created from (lookup key).
+    SDL_Texture* texture;                   // The texture.
+    int version;                            // bitmap->version at the last upload.
+} VirtualJoystickTextureEntry;
+
+// --- VirtualJoystickTextureSet Structure ---
+// The textures created for one renderer, one per shared bitmap. Sets are created lazily the first
+// time a joystick is drawn to a renderer and released by VirtualJoystick_ReleaseRenderer.
+typedef struct VirtualJoystickTextureSet {
+    SDL_Renderer* renderer;                 // Renderer that owns the textures in this set.
+    Uint32 window_id;                       // ID of the renderer's window (0 without one), to tell a new renderer at the same address apart.
+    JoystickBackend backend;                // Backend chosen for this renderer by _probe_renderer_backend.
+    bool probed;                            // True once the backend was timed or forced with VirtualJoystick_SetRendererBackend.
+    float probe_ms[JOYSTICK_BACKEND_COUNT]; // Probe timings, reported through VirtualJoystick_GetStats.
+    bool premultiplied;                     // True if textures hold premultiplied colors and use _premultiplied_blend_mode.
+    struct VirtualJoystickTextureEntry* entries; // One texture per bitmap (circles use none with the geometry backend).
+    int count;                              // Number of textures in the set.
+    int capacity;                           // Allocated length of entries.
+    bool needs_upload;                      // Set by SDL_RENDER_TARGETS_RESET: contents must be re-uploaded.
+    bool needs_recreate;                    // Set by SDL_RENDER_DEVICE_RESET: textures must be recreated.
+    struct VirtualJoystickTextureSet* next; // Next set in the list.
+} VirtualJoystickTextureSet;
+
+static VirtualJoystickBitmap* _shared_bitmaps = NULL;         // All live bitmaps, shared between joysticks.
+static VirtualJoystickTextureSet* _texture_sets = NULL;       // One texture set per renderer drawn to.
+static int _texture_uploads = 0;                              // Total texture uploads, for VirtualJoystick_GetStats.
+static int _layer_redraws = 0;                                // Controls re-rendered into HUD layers, for VirtualJoystick_GetStats.
+static int _device_resets = 0;                                // Number of SDL_RENDER_DEVICE_RESET events seen.
+static int _target_resets = 0;                                // Number of SDL_RENDER_TARGETS_RESET events seen.
+static int _last_state_changes = 0;                           // State changes of the last submitted draw list.
+static float _last_prepare_ms = 0.0f;                         // Duration of the last VirtualJoystick_PrepareBitmaps call.
+static int _last_prepare_threads = 0;                         // Threads used by the last VirtualJoystick_PrepareBitmaps call.
+static int _antialias_samples = 1;                            // Anti-aliasing used for bitmaps created by VirtualJoystick_Create.
+static VirtualJoystickBitmapCache _bitmap_cache = {NULL, 0, false, NULL, 0}; // The open on-disk cache, if any.
+
+// --- Memory Accounting ---
+// All heap memory goes through _joystick_malloc and friends, which call the functions installed
+// with VirtualJoystick_SetAllocator and keep each block's size in a small header so frees can be
+// counted. Textures go through _create_texture and _destroy_texture. The totals are guarded by a
+// spinlock because bitmaps are also allocated on the rasterization worker threads.
+#define VIRTUAL_JOYSTICK_ALLOC_HEADER 16 // Bytes in front of each allocation holding its size (keeps 16-byte alignment).
+
+static SDL_malloc_func _malloc_func = SDL_malloc;             // Allocator hooks, see VirtualJoystick_SetAllocator.
+static SDL_calloc_func _calloc_func = SDL_calloc;
+static SDL_realloc_func _realloc_func = SDL_realloc;
+static SDL_free_func _free_func = SDL_free;
+static SDL_SpinLock _memory_lock = 0;                         // Guards the totals below.
+static size_t _heap_bytes = 0;                                // Heap bytes currently allocated.
+static size_t _peak_heap_bytes = 0;                           // Highest _heap_bytes since startup.
+static int _allocation_count = 0;                             // Live heap allocations.
+static size_t _texture_bytes = 0;                             // Estimated bytes of live textures.
+static int _texture_count = 0;                                // Live textures.
+
+// --- Helper Function: _count_heap ---
+// Adds an allocation (or, with negative values, a free) to the heap totals.
+static inline void _count_heap(size_t added, size_t removed, int allocations) {
+    SDL_AtomicLock(&_memory_lock);
+    _heap_bytes = _heap_bytes + added - removed;
+    if (_heap_bytes > _peak_heap_bytes) _peak_heap_bytes = _heap_bytes;
+    _allocation_count += allocations;
+    SDL_AtomicUnlock(&_memory_lock);
+}
 
+// --- Helper Function: _joystick_malloc ---
+// malloc through the allocator hooks.
+static inline void* _joystick_malloc(size_t size) {
+    if (size > (size_t)-1 - VIRTUAL_JOYSTICK_ALLOC_HEADER) return NULL;
+    Uint8* block = (Uint8*)_malloc_func(size + VIRTUAL_JOYSTICK_ALLOC_HEADER);
+    if (!block) return NULL;
+    *(size_t*)block = size;
+    _count_heap(size, 0, 1);
+    return block + VIRTUAL_JOYSTICK_ALLOC_HEADER;
+}
+
+// --- Helper Function: _joystick_calloc ---
+// calloc through the allocator hooks.
+static inline void* _joystick_calloc(size_t count, size_t size) {
+    if (size && count > ((size_t)-1 - VIRTUAL_JOYSTICK_ALLOC_HEADER) / size) return NULL;
+    size_t bytes = count * size;
+    Uint8* block = (Uint8*)_calloc_func(1, bytes + VIRTUAL_JOYSTICK_ALLOC_HEADER);
+    if (!block) return NULL;
+    *(size_t*)block = bytes;
+    _count_heap(bytes, 0, 1);
+    return block + VIRTUAL_JOYSTICK_ALLOC_HEADER;
+}
+
+// --- Helper Function: _joystick_realloc ---
+// realloc through the allocator hooks. Like realloc, the old block stays valid on failure.
+static inline void* _joystick_realloc(void* pointer, size_t size) {
+    if (!pointer) return _joystick_malloc(size);
+    if (size > (size_t)-1 - VIRTUAL_JOYSTICK_ALLOC_HEADER) return NULL;
+    Uint8* old_block = (Uint8*)pointer - VIRTUAL_JOYSTICK_ALLOC_HEADER;
+    size_t old_size = *(size_t*)old_block;
+    Uint8* block = (Uint8*)_realloc_func(old_block, size + VIRTUAL_JOYSTICK_ALLOC_HEADER);
+    if (!block) return NULL;
+    *(size_t*)block = size;
+    _count_heap(size, old_size, 0);
+    return block + VIRTUAL_JOYSTICK_ALLOC_HEADER;
+}
+
+// --- Helper Function: _joystick_free ---
+// free through the allocator hooks, for memory from _joystick_malloc, _joystick_calloc or _joystick_realloc.
+static inline void _joystick_free(void* pointer) {
+    if (!pointer) return;
+    Uint8* block = (Uint8*)pointer - VIRTUAL_JOYSTICK_ALLOC_HEADER;
+    _count_heap(0, *(size_t*)block, -1);
+    _free_func(block);
+}
+
+// --- Helper Function: _count_texture ---
+// Adds a texture to the texture totals (sign 1) or removes it (sign -1). The size is estimated
+// from its dimensions and pixel format; drivers may use more.
+static inline void _count_texture(SDL_Texture* texture, int sign) {
+    Uint32 format;
+    int width, height;
+    if (!texture || SDL_QueryTexture(texture, &format, NULL, &width, &height) != 0) return;
+    size_t bytes = (size_t)width * (size_t)height * (size_t)SDL_BYTESPERPIXEL(format);
+    SDL_AtomicLock(&_memory_lock);
+    _texture_bytes = sign > 0 ? _texture_bytes + bytes : _texture_bytes - bytes;
+    _texture_count += sign;
+    SDL_AtomicUnlock(&_memory_lock);
+}
+
+// --- Helper Function: _create_texture ---
+// SDL_CreateTexture, counted in the texture totals.
+static inline SDL_Texture* _create_texture(SDL_Renderer* renderer, Uint32 format, int access, int width, int height) {
+    SDL_Texture* texture = SDL_CreateTexture(renderer, format, access, width, height);
+    _count_texture(texture, 1);
+    return texture;
+}
+
+// --- Helper Function: _destroy_texture ---
+// SDL_DestroyTexture for textures counted in the texture totals.
+static inline void _destroy_texture(SDL_Texture* texture) {
+    if (!texture) return;
+    _count_texture(texture, -1);
+    SDL_DestroyTexture(texture);
+}
+
+// --- Tracing ---
+// With VIRTUAL_JOYSTICK_TRACE defined to 1, HandleEvent, the logic update, texture creation and
+// Draw record begin/end spans and touches record instant events once VirtualJoystick_StartTrace
+// has been called. Each thread writes to its own fixed-size buffer (found through SDL thread-local
+// storage), so recording takes no locks; VirtualJoystick_WriteTrace saves all buffers as a Chrome
+// trace JSON file (chrome://tracing, ui.perfetto.dev). Without it, the macros compile to nothing.
+#ifndef VIRTUAL_JOYSTICK_TRACE
+    #define VIRTUAL_JOYSTICK_TRACE 0
+#endif
+
+#if VIRTUAL_JOYSTICK_TRACE
+#define VIRTUAL_JOYSTICK_TRACE_EVENTS 16384 // Events kept per thread; later events are dropped until the next write.
+
+// --- VirtualJoystickTraceEvent Structure ---
+// One recorded event.
+typedef struct {
+    const char* name;              // Name of the span or event (a string literal).
+    Uint64 counter;                // SDL_GetPerformanceCounter when it was recorded.
+    char phase;                    // 'B' (begin), 'E' (end) or 'i' (instant), as in the Chrome trace format.
+} VirtualJoystickTraceEvent;
+
+// --- VirtualJoystickTraceBuffer Structure ---
+// The events recorded by one thread. Only the owning thread writes to it; count is published
+// atomically after each event so VirtualJoystick_WriteTrace only reads complete events.
+typedef struct VirtualJoystickTraceBuffer {
+    SDL_threadID thread;           // Thread that owns the buffer.
+    SDL_atomic_t count;            // Number of recorded events.
+    VirtualJoystickTraceEvent events[VIRTUAL_JOYSTICK_TRACE_EVENTS];
+    struct VirtualJoystickTraceBuffer* next; // Next buffer in the list.
+} VirtualJoystickTraceBuffer;
+
+static SDL_TLSID _trace_tls = 0;                              // Thread-local slot holding each thread's buffer; 0 until tracing starts.
+static Uint64 _trace_start = 0;                               // Performance counter at VirtualJoystick_StartTrace.
+static void* _trace_buffers = NULL;                           // All VirtualJoystickTraceBuffers, pushed with SDL_AtomicCASPtr.
+
+// --- Helper Function: _trace ---
+// Records one event in the calling thread's buffer, creating the buffer on the thread's first event.
+static inline void _trace(const char* name, char phase) {
+    if (!_trace_tls) return; // Tracing has not been started.
+    VirtualJoystickTraceBuffer* buffer = (VirtualJoystickTraceBuffer*)SDL_TLSGet(_trace_tls);
+    if (!buffer) {
+        buffer = (VirtualJoystickTraceBuffer*)_joystick_calloc(1, sizeof(VirtualJoystickTraceBuffer));
+        if (!buffer) return;
+        buffer->thread = SDL_ThreadID();
+        // Buffers outlive their threads so their events can still be written, hence no destructor.
+        SDL_TLSSet(_trace_tls, buffer, NULL);
+        void* head;
+        do {
+            head = SDL_AtomicGetPtr(&_trace_buffers);
+            buffer->next = (VirtualJoystickTraceBuffer*)head;
+        } while (!SDL_AtomicCASPtr(&_trace_buffers, head, buffer));
+    }
+    int index = SDL_AtomicGet(&buffer->count);
+    if (index >= VIRTUAL_JOYSTICK_TRACE_EVENTS) return;
+    VirtualJoystickTraceEvent* event = &buffer->events[index];
+    event->name = name;
+    event->phase = phase;
+    event->counter = SDL_GetPerformanceCounter();
+    SDL_AtomicSet(&buffer->count, index + 1);
+}
+
+#define VIRTUAL_JOYSTICK_TRACE_BEGIN(name) _trace(name, 'B')
+#define VIRTUAL_JOYSTICK_TRACE_END(name) _trace(name, 'E')
+#define VIRTUAL_JOYSTICK_TRACE_INSTANT(name) _trace(name, 'i')
+#else
+#define VIRTUAL_JOYSTICK_TRACE_BEGIN(name) ((void)0)
+#define VIRTUAL_JOYSTICK_TRACE_END(name) ((void)0)
+#define VIRTUAL_JOYSTICK_TRACE_INSTANT(name) ((void)0)
+#endif
+
+#define VIRTUAL_JOYSTICK_ATLAS_SIZE 1024    // Width and height of a skin atlas page.
+#define VIRTUAL_JOYSTICK_ATLAS_PADDING 1    // Transparent gap kept around each skin so filtering does not bleed.
+
+// --- VirtualJoystickSkylineNode Structure ---
+// One segment of an atlas page's skyline: the pixels from x to x + width are used up to height y.
+typedef struct {
+    int x;
+    int y;
+    int width;
+} VirtualJoystickSkylineNode;
+
+// --- VirtualJoystickAtlasPage Structure ---
+// An RGBA page that skins are packed into with a skyline (bottom-left) packer.
+typedef struct VirtualJoystickAtlasPage {
+    VirtualJoystickBitmap bitmap;           // The page's pixels, uploaded like any other bitmap.
+    VirtualJoystickSkylineNode* skyline;    // Skyline segments sorted by x, covering the page width.
+    int skyline_count;                      // Number of skyline segments.
+    int skin_count;                         // Number of skins stored on the page.
+    struct VirtualJoystickAtlasPage* next;  // Next page in the list.
+} VirtualJoystickAtlasPage;
+
+static VirtualJoystickChange* _change_queue = NULL; // Pending change records, at most one per joystick.
+static int _change_count = 0;                       // Number of pending change records.
+static int _change_capacity = 0;                    // Allocated length of _change_queue.
+static int _joystick_count = 0;                     // Live joysticks; the change queue is freed with the last one.
+
+static VirtualJoystickAtlasPage* _atlas_pages = NULL;        // All skin atlas pages.
+static VirtualJoystickSkin* _skins = NULL;                    // All loaded skins.
+
+// --- Helper Function: _normalize_aa_samples ---
+// Clamps an anti-aliasing sample count to the supported range (values below 2 mean hard edges).
+static inline int _normalize_aa_samples(int samples) {
+    if (samples < 1) return 1;
+    return samples > VIRTUAL_JOYSTICK_MAX_AA_SAMPLES ? VIRTUAL_JOYSTICK_MAX_AA_SAMPLES : samples;
+}
+
+// --- Helper Function: _rasterize_circle_bitmap ---
+// Rasterizes a filled circle into a CPU-side coverage bitmap. Without anti-aliasing the pixel
+// coverage test is the same one the joystick always used, so the result matches the previous
+// point-by-point drawing.
+// Parameters:
+//   bitmap: The bitmap to fill. Its alpha buffer is allocated here and must be released with _joystick_free().
+//   radius: The radius of the circle to rasterize.
+//   color: The SDL_Color of the circle.
+//   aa_samples: Anti-aliasing samples per axis (1 = hard edges). Each pixel's coverage is the
+//               fraction of its aa_samples x aa_samples sub-samples inside the circle.
+// Returns: true on success, false if the allocation failed.
+static inline bool _rasterize_circle_bitmap(VirtualJoystickBitmap* bitmap, int radius, SDL_Color color, int aa_samples) {
+    int diameter = radius * 2;
+    bitmap->width = diameter;
+    bitmap->height = diameter;
+    bitmap->color = color;
+    bitmap->aa_samples = _normalize_aa_samples(aa_samples);
+    bitmap->pixels = NULL;
+    bitmap->version = 0;
+    bitmap->_mapped = false;
+    bitmap->alpha = (Uint8*)_joystick_malloc((size_t)diameter * (size_t)diameter);
+    if (!bitmap->alpha) {
+        fprintf(stderr, "Failed to allocate circle bitmap\n");
+        return false;
+    }
+
+    if (bitmap->aa_samples > 1) {
+        // Sub-sample rows each cover one span of sub-sample columns; add up how many of each
+        // pixel's sub-samples fall inside and scale the total to 0..255.
+        int n = bitmap->aa_samples;
+        int full = n * n;
+        Uint16* coverage = (Uint16*)_joystick_malloc((size_t)diameter * sizeof(Uint16));
+        if (!coverage) {
+            fprintf(stderr, "Failed to allocate circle bitmap\n");
+            _joystick_free(bitmap->alpha);
+            bitmap->alpha = NULL;
+            return false;
+        }
+        for (int py = 0; py < diameter; py++) {
+            SDL_memset(coverage, 0, (size_t)diameter * sizeof(Uint16));
+            for (int sy = 0; sy < n; sy++) {
+                float y = py - radius + (sy + 0.5f) / n;
+                float remaining = (float)radius * radius - y * y;
+                if (remaining < 0.0f) continue;
+                float half_width = sqrtf(remaining);
+                // Sub-sample column g sits at x = g / n + 0.5 / n - radius.
+                int first = (int)ceilf((radius - half_width) * n - 0.5f);
+                int last = (int)floorf((radius + half_width) * n - 0.5f);
+                if (first < 0) first = 0;
+                if (last > diameter * n - 1) last = diameter * n - 1;
+                for (int g = first; g <= last;) {
+                    int px = g / n;
+                    int span_end = (px + 1) * n - 1 < last ? (px + 1) * n - 1 : last;
+                    coverage[px] = (Uint16)(coverage[px] + span_end - g + 1);
+                    g = span_end + 1;
+                }
+            }
+            for (int px = 0; px < diameter; px++) {
+                bitmap->alpha[py * diameter + px] = (Uint8)((coverage[px] * 255 + full / 2) / full);
+            }
+        }
+        _joystick_free(coverage);
+        return true;
+    }
+
+    // Mark every pixel whose offset from the center lies within the radius as covered. The covered
+    // pixels of a row form one span, so find its half-width once and fill the row with memset.
+    Uint8* row = bitmap->alpha;
+    for (int y = -radius; y < radius; y++) {
+        int remaining = radius * radius - y * y;
+        int half_width = (int)sqrtf((float)remaining);
+        while (half_width * half_width > remaining) half_width--;
+        while ((half_width + 1) * (half_width + 1) <= remaining) half_width++;
+
+        int first = radius - half_width;                                         // Leftmost covered column.
+        int last = radius + half_width < diameter - 1 ? radius + half_width : diameter - 1; // Rightmost covered column.
+        SDL_memset(row, 0, (size_t)first);
+        SDL_memset(row + first, 255, (size_t)(last - first + 1));
+        SDL_memset(row + last + 1, 0, (size_t)(diameter - last - 1));
+        row += diameter;
+    }
+    return true;
+}
+
+// --- Helper Function: _premultiplied_blend_mode ---
+// Blend mode for textures whose colors are already multiplied by their alpha:
+// dst = src + dst * (1 - src alpha), for color and alpha alike.
+static inline SDL_BlendMode _premultiplied_blend_mode(void) {
+    return SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                      SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+}
+
+// --- Helper Function: _premultiply_pixel ---
+// Multiplies the color channels of an SDL_PIXELFORMAT_RGBA8888 pixel by its alpha.
+static inline Uint32 _premultiply_pixel(Uint32 pixel) {
+    Uint32 a = pixel & 0xFF;
+    if (a == 255) return pixel;
+    return ((((pixel >> 24) & 0xFF) * a / 255) << 24) | ((((pixel >> 16) & 0xFF) * a / 255) << 16) |
+           ((((pixel >> 8) & 0xFF) * a / 255) << 8) | a;
+}
+
+// --- Helper Function: _expand_bitmap ---
+// Expands a coverage bitmap to SDL_PIXELFORMAT_RGBA8888 pixels in a single pass.
+// Parameters:
+//   bitmap: The bitmap to expand.
+//   premultiplied: true to multiply the color channels by each pixel's alpha. Premultiplied
+//                  pixels keep their edges free of dark fringes when the texture is scaled.
+//                  With straight alpha, uncovered pixels keep the circle's color at alpha 0
+//                  instead, so filtering across the edge blends toward that color, not black.
+// Returns: A malloc'ed buffer of width * height pixels (free it with _joystick_free()), or NULL on failure.
+static inline Uint32* _expand_bitmap(const VirtualJoystickBitmap* bitmap, bool premultiplied) {
+    int pixel_count = bitmap->width * bitmap->height;
+    Uint32* pixels = (Uint32*)_joystick_malloc((size_t)pixel_count * sizeof(Uint32));
+    if (!pixels) {
+        fprintf(stderr, "Failed to allocate texture upload buffer\n");
+        return NULL;
+    }
+
+    if (bitmap->pixels) {
+        // Skin pixels are stored with straight alpha and only need premultiplying.
+        for (int i = 0; i < pixel_count; i++) {
+            pixels[i] = premultiplied ? _premultiply_pixel(bitmap->pixels[i]) : bitmap->pixels[i];
+        }
+        return pixels;
+    }
+
+    // A bitmap only has 256 distinct coverage values, so convert each one once and look it up.
+    // SDL_PIXELFORMAT_RGBA8888 packs the channels as 0xRRGGBBAA. Premultiplied uncovered pixels
+    // are transparent black; straight ones keep the color (see above).
+    Uint32 lookup[256];
+    for (Uint32 coverage = 0; coverage < 256; coverage++) {
+        Uint32 a = coverage * bitmap->color.a / 255;
+        Uint32 scale = premultiplied ? a : 255;
+        lookup[coverage] = (((Uint32)bitmap->color.r * scale / 255) << 24) | (((Uint32)bitmap->color.g * scale / 255) << 16) |
+                           (((Uint32)bitmap->color.b * scale / 255) << 8) | a;
+    }
+    for (int i = 0; i < pixel_count; i++) {
+        pixels[i] = lookup[bitmap->alpha[i]];
+    }
+    return pixels;
+}
+
+// --- Helper Function: _upload_bitmap ---
+// Expands a coverage bitmap and uploads it into a texture.
+// Parameters:
+//   texture: The texture to upload to. It must be bitmap->width x bitmap->height in size.
+//   bitmap: The cached bitmap to upload.
+//   premultiplied: true if the texture is drawn with _premultiplied_blend_mode.
+// Returns: true on success, false on failure.
+static inline bool _upload_bitmap(SDL_Texture* texture, const VirtualJoystickBitmap* bitmap, bool premultiplied) {
+    Uint32* pixels = _expand_bitmap(bitmap, premultiplied);
+    if (!pixels) return false;
+
+    bool ok = SDL_UpdateTexture(texture, NULL, pixels, bitmap->width * (int)sizeof(Uint32)) == 0;
+    if (!ok) {
+        fprintf(stderr, "Failed to upload circle texture: %s\n", SDL_GetError());
+    }
+    _texture_uploads++;
+    _joystick_free(pixels);
+    return ok;
+}
+
+// --- Helper Function: _upload_bitmap_region ---
+// Uploads one rectangle of a skin atlas page into the page's texture, so adding a skin does not
+// re-upload the whole page.
+// Parameters:
+//   texture: The texture of the page. It must be in SDL_PIXELFORMAT_RGBA8888.
+//   bitmap: The atlas page's bitmap (with pixels).
+//   rect: The part of the page to upload.
+//   premultiplied: true if the texture is drawn with _premultiplied_blend_mode.
+// Returns: true on success, false on failure.
+static inline bool _upload_bitmap_region(SDL_Texture* texture, const VirtualJoystickBitmap* bitmap, const SDL_Rect* rect, bool premultiplied) {
+    Uint32* pixels = (Uint32*)_joystick_malloc((size_t)rect->w * (size_t)rect->h * sizeof(Uint32));
+    if (!pixels) {
+        fprintf(stderr, "Failed to allocate texture upload buffer\n");
+        return false;
+    }
+    for (int y = 0; y < rect->h; y++) {
+        const Uint32* src = bitmap->pixels + (size_t)(rect->y + y) * (size_t)bitmap->width + rect->x;
+        Uint32* dst = pixels + (size_t)y * (size_t)rect->w;
+        for (int x = 0; x < rect->w; x++) {
+            dst[x] = premultiplied ? _premultiply_pixel(src[x]) : src[x];
+        }
+    }
+
+    bool ok = SDL_UpdateTexture(texture, rect, pixels, rect->w * (int)sizeof(Uint32)) == 0;
+    if (!ok) {
+        fprintf(stderr, "Failed to upload skin texture: %s\n", SDL_GetError());
+    }
+    _texture_uploads++;
+    _joystick_free(pixels);
+    return ok;
+}
+
+// --- Helper Function: create_circle_texture ---
+// Creates an SDL_Texture from a cached circle bitmap (or skin atlas page). This is used to draw
+// the joystick's base and tip.
+// Parameters:
+//   renderer: The SDL_Renderer to create the texture with.
+//   bitmap: The rasterized circle to upload into the texture.
+//   backend: How the texture is created (JOYSTICK_BACKEND_TARGET_TEXTURE, _STATIC_TEXTURE or _SURFACE).
+//   premultiplied: true to store premultiplied colors and draw with _premultiplied_blend_mode.
+//                  Only pass true for renderers that accept that blend mode (see _probe_renderer_backend).
+// Returns: An SDL_Texture* on success, NULL on failure.
+static inline SDL_Texture* create_circle_texture(SDL_Renderer* renderer, const VirtualJoystickBitmap* bitmap, JoystickBackend backend, bool premultiplied) {
+    VIRTUAL_JOYSTICK_TRACE_BEGIN("create_circle_texture");
+    SDL_Texture* texture = NULL;
+    if (backend == JOYSTICK_BACKEND_SURFACE) {
+        // Let SDL convert the pixels to the renderer's preferred format once, instead of on every blit.
+        Uint32* pixels = _expand_bitmap(bitmap, premultiplied);
+        if (!pixels) {
+            VIRTUAL_JOYSTICK_TRACE_END("create_circle_texture");
+            return NULL;
+        }
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(pixels, bitmap->width, bitmap->height, 32,
+                                                                  bitmap->width * (int)sizeof(Uint32), SDL_PIXELFORMAT_RGBA8888);
+        if (surface) {
+            texture = SDL_CreateTextureFromSurface(renderer, surface);
+            _count_texture(texture, 1);
+            SDL_FreeSurface(surface);
+        }
+        _joystick_free(pixels);
+        _texture_uploads++;
+    } else {
+        // Create a texture with RGBA format and render target or static access.
+        int access = backend == JOYSTICK_BACKEND_TARGET_TEXTURE ? SDL_TEXTUREACCESS_TARGET : SDL_TEXTUREACCESS_STATIC;
+        texture = _create_texture(renderer, SDL_PIXELFORMAT_RGBA8888, access, bitmap->width, bitmap->height);
+        if (texture && !_upload_bitmap(texture, bitmap, premultiplied)) {
+            _destroy_texture(texture);
+            texture = NULL;
+        }
+    }
+    if (!texture) {
+        fprintf(stderr, "Failed to create circle texture: %s\n", SDL_GetError());
+        VIRTUAL_JOYSTICK_TRACE_END("create_circle_texture");
+        return NULL;
+    }
+
+    // Enable blending for transparency.
+    SDL_SetTextureBlendMode(texture, premultiplied ? _premultiplied_blend_mode() : SDL_BLENDMODE_BLEND);
+    VIRTUAL_JOYSTICK_TRACE_END("create_circle_texture");
+    return texture;
+}
+
+// --- Helper Function: _draw_circle_geometry ---
+// Draws a filled circle as a triangle fan with SDL_RenderGeometry (JOYSTICK_BACKEND_GEOMETRY).
+// Parameters:
+//   renderer: The SDL_Renderer to draw with.
+//   center: Center of the circle on screen.
+//   radius: Radius of the circle in pixels.
+//   color: Vertex color of the circle.
+static inline void _draw_circle_geometry(SDL_Renderer* renderer, SDL_FPoint center, float radius, SDL_Color color) {
+#if VIRTUAL_JOYSTICK_HAS_GEOMETRY
+    // The unit circle and the fan indices are the same for every circle, so build them once.
+    static SDL_FPoint unit_circle[VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS];
+    static int indices[VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS * 3];
+    static bool tables_ready = false;
+    if (!tables_ready) {
+        for (int i = 0; i < VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS; i++) {
+            float angle = 2.0f * 3.14159265f * i / VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS;
+            unit_circle[i] = (SDL_FPoint){cosf(angle), sinf(angle)};
+            indices[i * 3] = 0;
+            indices[i * 3 + 1] = 1 + i;
+            indices[i * 3 + 2] = 1 + (i + 1) % VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS;
+        }
+        tables_ready = true;
+    }
+
+    SDL_Vertex vertices[VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS + 1];
+    vertices[0].position = center;
+    vertices[0].color = color;
+    vertices[0].tex_coord = (SDL_FPoint){0.0f, 0.0f};
+    for (int i = 0; i < VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS; i++) {
+        vertices[i + 1].position = (SDL_FPoint){center.x + unit_circle[i].x * radius, center.y + unit_circle[i].y * radius};
+        vertices[i + 1].color = color;
+        vertices[i + 1].tex_coord = (SDL_FPoint){0.0f, 0.0f};
+    }
+    // Untextured geometry uses the renderer's draw blend mode, which defaults to no blending.
+    SDL_BlendMode previous_blend_mode;
+    SDL_GetRenderDrawBlendMode(renderer, &previous_blend_mode);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_RenderGeometry(renderer, NULL, vertices, VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS + 1, indices, VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS * 3);
+    SDL_SetRenderDrawBlendMode(renderer, previous_blend_mode);
+#else
+    (void)renderer; (void)center; (void)radius; (void)color;
+#endif
+}
+
+// --- Helper Function: _init_texture_set ---
+// Fills in what can be learned about a renderer without drawing: whether it accepts the
+// premultiplied blend mode, and a default backend for its type (surface-format textures for
+// software renderers, static textures otherwise).
+static inline void _init_texture_set(VirtualJoystickTextureSet* set) {
+    SDL_Renderer* renderer = set->renderer;
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) != 0) {
+        info.flags = 0;
+    }
+
+    // Premultiplied alpha needs a custom blend mode, which not every renderer accepts. The SDL
+    // software renderer accepts none, so it keeps straight alpha with SDL_BLENDMODE_BLEND and
+    // draws exactly as fast as before; it only gets the color-bled edges of _expand_bitmap.
+    SDL_Texture* blend_test = _create_texture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 1, 1);
+    set->premultiplied = blend_test && SDL_SetTextureBlendMode(blend_test, _premultiplied_blend_mode()) == 0;
+    if (blend_test) _destroy_texture(blend_test);
+
+    set->backend = (info.flags & SDL_RENDERER_SOFTWARE) ? JOYSTICK_BACKEND_SURFACE : JOYSTICK_BACKEND_STATIC_TEXTURE;
+}
+
+// --- Helper Function: _wait_for_renderer ---
+// Blocks until the renderer has finished the commands submitted so far, by reading back one
+// pixel of the current target. Timings taken between two calls include the GPU's work.
+static inline void _wait_for_renderer(SDL_Renderer* renderer) {
+    Uint32 pixel;
+    SDL_Rect rect = {0, 0, 1, 1};
+    SDL_RenderReadPixels(renderer, &rect, SDL_PIXELFORMAT_RGBA8888, &pixel, (int)sizeof(pixel));
+}
+
+// --- Helper Function: _probe_renderer_backend ---
+// Times the backends the renderer supports by drawing a small circle into an offscreen target,
+// and switches from the default backend (see _init_texture_set) to another one only if it is
+// clearly faster. This switches render targets, so it only runs outside of drawing: when a
+// joystick is created, when bitmaps are prepared, or through VirtualJoystick_SetRendererBackend.
+// Render-target textures draw exactly like static ones and lose their contents on
+// SDL_RENDER_TARGETS_RESET, so they are not candidates.
+static inline void _probe_renderer_backend(VirtualJoystickTextureSet* set) {
+    SDL_Renderer* renderer = set->renderer;
+    set->probed = true;
+    SDL_memset(set->probe_ms, 0, sizeof(set->probe_ms));
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) != 0 || !(info.flags & SDL_RENDERER_TARGETTEXTURE)) {
+        // Without render targets there is nowhere to time draws without touching the screen.
+        return;
+    }
+
+    VirtualJoystickBitmap probe_bitmap;
+    if (!_rasterize_circle_bitmap(&probe_bitmap, 16, (SDL_Color){255, 255, 255, 255}, 1)) return;
+    SDL_Texture* scratch = _create_texture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, 64, 64);
+    if (!scratch) {
+        _joystick_free(probe_bitmap.alpha);
+        return;
+    }
+
+    // Each candidate's texture is created once; NULL marks geometry or a failed creation.
+    static const JoystickBackend candidates[] = {JOYSTICK_BACKEND_STATIC_TEXTURE, JOYSTICK_BACKEND_GEOMETRY, JOYSTICK_BACKEND_SURFACE};
+    enum { CANDIDATE_COUNT = (int)(sizeof(candidates) / sizeof(candidates[0])) };
+    SDL_Texture* textures[CANDIDATE_COUNT];
+    bool supported[CANDIDATE_COUNT];
+    for (int c = 0; c < CANDIDATE_COUNT; c++) {
+        textures[c] = NULL;
+        if (candidates[c] == JOYSTICK_BACKEND_GEOMETRY) {
+            supported[c] = VIRTUAL_JOYSTICK_HAS_GEOMETRY;
+        } else {
+            textures[c] = create_circle_texture(renderer, &probe_bitmap, candidates[c], set->premultiplied);
+            supported[c] = textures[c] != NULL;
+        }
+    }
+
+    SDL_Texture* previous_target = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, scratch);
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    // Rounds alternate between the candidates so a slow moment does not count against just one.
+    for (int round = 0; round < VIRTUAL_JOYSTICK_PROBE_ROUNDS; round++) {
+        for (int c = 0; c < CANDIDATE_COUNT; c++) {
+            if (!supported[c]) continue;
+            SDL_Texture* texture = textures[c];
+
+            // One untimed draw first so lazy driver setup does not count against the backend.
+            SDL_Rect dst_rect = {0, 0, probe_bitmap.width, probe_bitmap.height};
+            Uint64 start = 0;
+            for (int i = 0; i <= VIRTUAL_JOYSTICK_PROBE_DRAWS; i++) {
+                if (i == 1) {
+                    _wait_for_renderer(renderer);
+                    start = SDL_GetPerformanceCounter();
+                }
+                dst_rect.x = dst_rect.y = i % 32;
+                if (texture) {
+                    SDL_SetTextureColorMod(texture, 255, (Uint8)i, 255);
+                    SDL_RenderCopy(renderer, texture, NULL, &dst_rect);
+                } else {
+                    _draw_circle_geometry(renderer, (SDL_FPoint){dst_rect.x + 16.0f, dst_rect.y + 16.0f}, 16.0f, (SDL_Color){255, (Uint8)i, 255, 255});
+                }
+            }
+            _wait_for_renderer(renderer);
+            float elapsed_ms = (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)frequency);
+
+            float* best_ms = &set->probe_ms[candidates[c]];
+            if (round == 0 || elapsed_ms < *best_ms) *best_ms = elapsed_ms;
+        }
+    }
+    SDL_SetRenderTarget(renderer, previous_target);
+
+    // Keep the default unless a candidate beats it by a clear margin (or the default failed).
+    float default_ms = set->probe_ms[set->backend];
+    for (int c = 0; c < CANDIDATE_COUNT; c++) {
+        if (!supported[c]) continue;
+        float elapsed_ms = set->probe_ms[candidates[c]];
+        if (default_ms <= 0.0f || elapsed_ms < default_ms * VIRTUAL_JOYSTICK_PROBE_MARGIN) {
+            set->backend = candidates[c];
+            default_ms = elapsed_ms;
+        }
+    }
+
+    for (int c = 0; c < CANDIDATE_COUNT; c++) {
+        if (textures[c]) _destroy_texture(textures[c]);
+    }
+    _destroy_texture(scratch);
+    _joystick_free(probe_bitmap.alpha);
+}
+
+// --- Helper Function: _find_circle_bitmap ---
+// Looks up a shared circle bitmap with the given radius, color and anti-aliasing.
+// Returns: The bitmap, or NULL if there is none.
+static inline VirtualJoystickBitmap* _find_circle_bitmap(int radius, SDL_Color color, int aa_samples) {
+    for (VirtualJoystickBitmap* bitmap = _shared_bitmaps; bitmap; bitmap = bitmap->_next) {
+        if (bitmap->width == radius * 2 && bitmap->aa_samples == aa_samples && bitmap->color.r == color.r &&
+            bitmap->color.g == color.g && bitmap->color.b == color.b && bitmap->color.a == color.a) {
+            return bitmap;
+        }
+    }
+    return NULL;
+}
+
+// --- Helper Function: _register_bitmap ---
+// Adds a newly generated bitmap to the shared bitmap list with one reference.
+static inline void _register_bitmap(VirtualJoystickBitmap* bitmap) {
+    bitmap->_refcount = 1;
+    bitmap->_prepared = false;
+    bitmap->_next = _shared_bitmaps;
+    _shared_bitmaps = bitmap;
+}
+
+// --- Helper Function: _is_cache_entry_valid ---
+// Checks that an entry of the open on-disk cache describes a bitmap that lies inside the file.
+static inline bool _is_cache_entry_valid(const VirtualJoystickCacheEntry* entry) {
+    if (entry->radius <= 0 || entry->radius > 0x7FFF || entry->offset > _bitmap_cache.size) return false;
+    size_t bytes = (size_t)entry->radius * 2 * (size_t)entry->radius * 2;
+    return bytes <= _bitmap_cache.size - entry->offset;
+}
+
+// --- Helper Function: _load_cached_bitmap ---
+// Looks up a circle bitmap in the open on-disk cache and, on a hit, registers a shared bitmap
+// whose alpha data points straight into the cache file. Invalid entries are skipped.
+// Returns: The new bitmap with one reference, or NULL on a miss.
+static inline VirtualJoystickBitmap* _load_cached_bitmap(int radius, SDL_Color color, int aa_samples) {
+    for (Uint32 i = 0; i < _bitmap_cache.entry_count; i++) {
+        const VirtualJoystickCacheEntry* entry = &_bitmap_cache.entries[i];
+        if (entry->radius != radius || entry->aa_samples != aa_samples || entry->color[0] != color.r ||
+            entry->color[1] != color.g || entry->color[2] != color.b || entry->color[3] != color.a ||
+            !_is_cache_entry_valid(entry)) {
+            continue;
+        }
+
+        VirtualJoystickBitmap* bitmap = (VirtualJoystickBitmap*)_joystick_malloc(sizeof(VirtualJoystickBitmap));
+        if (!bitmap) return NULL;
+        bitmap->width = radius * 2;
+        bitmap->height = radius * 2;
+        bitmap->color = color;
+        bitmap->aa_samples = aa_samples;
+        bitmap->alpha = (Uint8*)(_bitmap_cache.data + entry->offset);
+        bitmap->pixels = NULL;
+        bitmap->version = 0;
+        bitmap->_mapped = true;
+        _register_bitmap(bitmap);
+        return bitmap;
+    }
+    return NULL;
+}
+
+// --- Helper Function: _acquire_circle_bitmap ---
+// Returns a shared circle bitmap with the given radius, color and anti-aliasing. It is only
+// rasterized if no other joystick already uses an identical one, it was not prepared ahead of
+// time, and it is not in the on-disk cache.
+// Returns: The bitmap with its reference count increased, or NULL on failure.
+static inline VirtualJoystickBitmap* _acquire_circle_bitmap(int radius, SDL_Color color, int aa_samples) {
+    aa_samples = _normalize_aa_samples(aa_samples);
+    VirtualJoystickBitmap* bitmap = _find_circle_bitmap(radius, color, aa_samples);
+    if (bitmap) {
+        bitmap->_refcount++;
+        return bitmap;
+    }
+    bitmap = _load_cached_bitmap(radius, color, aa_samples);
+    if (bitmap) return bitmap;
+
+    bitmap = (VirtualJoystickBitmap*)_joystick_malloc(sizeof(VirtualJoystickBitmap));
+    if (!bitmap) {
+        fprintf(stderr, "Failed to allocate circle bitmap\n");
+        return NULL;
+    }
+    if (!_rasterize_circle_bitmap(bitmap, radius, color, aa_samples)) {
+        _joystick_free(bitmap);
+        return NULL;
+    }
+    _register_bitmap(bitmap);
+    return bitmap;
+}
+
+// --- Helper Function: _renderer_window_id ---
+// Returns: The ID of the window a renderer draws to, or 0 if it has none (software renderers).
+static inline Uint32 _renderer_window_id(SDL_Renderer* renderer) {
+    SDL_Window* window = SDL_RenderGetWindow(renderer);
+    return window ? SDL_GetWindowID(window) : 0;
+}
+
+// --- Helper Function: _forget_texture_set ---
+// Empties a texture set whose renderer was destroyed without VirtualJoystick_ReleaseRenderer and
+// prepares it for the renderer now at its address. The old textures died with their renderer, so
+// they are only dropped from the texture totals (sized from their bitmaps, as they can no longer
+// be queried), never destroyed.
+static inline void _forget_texture_set(VirtualJoystickTextureSet* set, Uint32 window_id) {
+    SDL_AtomicLock(&_memory_lock);
+    for (int i = 0; i < set->count; i++) {
+        const VirtualJoystickBitmap* bitmap = set->entries[i].bitmap;
+        size_t bytes = (size_t)bitmap->width * (size_t)bitmap->height * 4;
+        _texture_bytes -= bytes < _texture_bytes ? bytes : _texture_bytes;
+        _texture_count--;
+    }
+    SDL_AtomicUnlock(&_memory_lock);
+    set->count = 0;
+    set->window_id = window_id;
+    set->probed = false;
+    SDL_memset(set->probe_ms, 0, sizeof(set->probe_ms));
+    set->needs_upload = false;
+    set->needs_recreate = false;
+    _init_texture_set(set);
+}
+
+// --- Helper Function: _find_texture_set ---
+// Finds the texture set of a renderer, optionally creating an empty one. A set found for a
+// renderer on another window belongs to a destroyed renderer whose address was reused, and is
+// started over (see _forget_texture_set). A new renderer on the same window cannot be told apart,
+// so VirtualJoystick_ReleaseRenderer is still required before destroying a renderer.
+// Returns: The texture set, or NULL if there is none (or it could not be allocated).
+static inline VirtualJoystickTextureSet* _find_texture_set(SDL_Renderer* renderer, bool create) {
+    for (VirtualJoystickTextureSet* set = _texture_sets; set; set = set->next) {
+        if (set->renderer != renderer) continue;
+        Uint32 window_id = _renderer_window_id(renderer);
+        if (set->window_id != window_id) _forget_texture_set(set, window_id);
+        return set;
+    }
+    if (!create) return NULL;
+
+    VirtualJoystickTextureSet* set = (VirtualJoystickTextureSet*)_joystick_calloc(1, sizeof(VirtualJoystickTextureSet));
+    if (!set) {
+        fprintf(stderr, "Failed to allocate texture set\n");
+        return NULL;
+    }
+    set->renderer = renderer;
+    set->window_id = _renderer_window_id(renderer);
+    _init_texture_set(set);
+    set->next = _texture_sets;
+    _texture_sets = set;
+    return set;
+}
+
+// --- Helper Function: _clear_texture_set ---
+// Destroys all textures of a texture set; they are recreated on demand.
+static inline void _clear_texture_set(VirtualJoystickTextureSet* set) {
+    for (int i = 0; i < set->count; i++) {
+        _destroy_texture(set->entries[i].texture);
+    }
+    set->count = 0;
+}
+
+// --- Helper Function: _restore_texture_set ---
+// Applies a pending renderer reset to a texture set in a single pass. After a device reset the
+// textures are dropped and recreated on demand; after a target reset only render-target
+// textures are re-uploaded from their cached bitmaps, since the other backends keep their contents.
+static inline void _restore_texture_set(VirtualJoystickTextureSet* set) {
+    if (set->needs_recreate) {
+        _clear_texture_set(set);
+    } else if (set->needs_upload && set->backend == JOYSTICK_BACKEND_TARGET_TEXTURE) {
+        for (int i = 0; i < set->count; i++) {
+            _upload_bitmap(set->entries[i].texture, set->entries[i].bitmap, set->premultiplied);
+        }
+    }
+    set->needs_recreate = false;
+    set->needs_upload = false;
+}
+
+// --- Helper Function: _get_texture_set ---
+// Returns the texture set of a renderer ready for drawing: created on first use, with any
+// pending renderer reset applied.
+// Parameters:
+//   renderer: The SDL_Renderer to get the texture set of.
+//   probe: true to time the backends if that was not done yet. Pass false while drawing, where
+//          switching render targets is not allowed; the default backend is used until a probe.
+// Returns: The texture set, or NULL on failure.
+static inline VirtualJoystickTextureSet* _get_texture_set(SDL_Renderer* renderer, bool probe) {
+    VirtualJoystickTextureSet* set = _find_texture_set(renderer, true);
+    if (set && probe && !set->probed) {
+        JoystickBackend previous_backend = set->backend;
+        _probe_renderer_backend(set);
+        if (set->backend != previous_backend) _clear_texture_set(set);
+    }
+    if (set && (set->needs_recreate || set->needs_upload)) _restore_texture_set(set);
+    return set;
+}
+
+// --- Helper Function: _get_bitmap_texture ---
+// Returns the texture of a bitmap in a renderer's texture set, creating it on first use and
+// re-uploading it if the bitmap changed (skins were added to an atlas page).
+// Returns: The texture, or NULL on failure (or for circles if the set uses the geometry backend).
+static inline SDL_Texture* _get_bitmap_texture(VirtualJoystickTextureSet* set, const VirtualJoystickBitmap* bitmap) {
+    // Geometry can only draw circles; skin atlas pages still need static textures.
+    JoystickBackend backend = set->backend;
+    if (backend == JOYSTICK_BACKEND_GEOMETRY) {
+        if (!bitmap->pixels) return NULL;
+        backend = JOYSTICK_BACKEND_STATIC_TEXTURE;
+    }
+
+    for (int i = 0; i < set->count; i++) {
+        VirtualJoystickTextureEntry* entry = &set->entries[i];
+        if (entry->bitmap != bitmap) continue;
+        if (entry->version != bitmap->version) {
+            if (backend == JOYSTICK_BACKEND_SURFACE) {
+                SDL_Texture* texture = create_circle_texture(set->renderer, bitmap, backend, set->premultiplied);
+                if (!texture) return NULL;
+                _destroy_texture(entry->texture);
+                entry->texture = texture;
+            } else {
+                _upload_bitmap(entry->texture, bitmap, set->premultiplied);
+            }
+            entry->version = bitmap->version;
+        }
+        return entry->texture;
+    }
+
+    if (set->count == set->capacity) {
+        int capacity = set->capacity ? set->capacity * 2 : 4;
+        VirtualJoystickTextureEntry* entries = (VirtualJoystickTextureEntry*)_joystick_realloc(set->entries, (size_t)capacity * sizeof(*entries));
+        if (!entries) return NULL;
+        set->entries = entries;
+        set->capacity = capacity;
+    }
+
+    SDL_Texture* texture = create_circle_texture(set->renderer, bitmap, backend, set->premultiplied);
+    if (!texture) return NULL;
+    set->entries[set->count].bitmap = bitmap;
+    set->entries[set->count].texture = texture;
+    set->entries[set->count].version = bitmap->version;
+    set->count++;
+    return texture;
+}
+
+// --- Helper Function: _update_bitmap_textures ---
+// Brings the up-to-date textures of an atlas page on every renderer to the page's new version
+// by uploading just the changed rectangle. Textures that were already out of date, and the
+// converted textures of the surface backend, keep the full re-upload on their next use.
+// Parameters:
+//   bitmap: The atlas page's bitmap, with its version already increased.
+//   rect: The part of the page that changed.
+static inline void _update_bitmap_textures(const VirtualJoystickBitmap* bitmap, const SDL_Rect* rect) {
+    for (VirtualJoystickTextureSet* set = _texture_sets; set; set = set->next) {
+        if (set->backend == JOYSTICK_BACKEND_SURFACE || set->needs_recreate) continue;
+        for (int i = 0; i < set->count; i++) {
+            VirtualJoystickTextureEntry* entry = &set->entries[i];
+            if (entry->bitmap == bitmap && entry->version == bitmap->version - 1 &&
+                _upload_bitmap_region(entry->texture, bitmap, rect, set->premultiplied)) {
+                entry->version = bitmap->version;
+            }
+        }
+    }
+}
+
+// --- Helper Function: _evict_bitmap_textures ---
+// Destroys the textures of a bitmap on every renderer.
+static inline void _evict_bitmap_textures(const VirtualJoystickBitmap* bitmap) {
+    for (VirtualJoystickTextureSet* set = _texture_sets; set; set = set->next) {
+        for (int i = 0; i < set->count; i++) {
+            if (set->entries[i].bitmap == bitmap) {
+                _destroy_texture(set->entries[i].texture);
+                set->entries[i] = set->entries[--set->count];
+                break;
+            }
+        }
+    }
+}
+
+// --- Helper Function: _release_bitmap ---
+// Drops one reference to a shared bitmap. The last reference frees the bitmap and its
+// textures on every renderer.
+static inline void _release_bitmap(VirtualJoystickBitmap* bitmap) {
+    if (!bitmap || --bitmap->_refcount > 0) return;
+
+    _evict_bitmap_textures(bitmap);
+
+    for (VirtualJoystickBitmap** link = &_shared_bitmaps; *link; link = &(*link)->_next) {
+        if (*link == bitmap) {
+            *link = bitmap->_next;
+            break;
+        }
+    }
+    if (!bitmap->_mapped) {
+        _joystick_free(bitmap->alpha);
+    }
+    _joystick_free(bitmap);
+}
+
+// --- Helper Function: _draw_bitmap ---
+// Draws a shared bitmap with the renderer's backend.
+// Parameters:
+//   set: The texture set of the renderer to draw with (from _get_texture_set).
+//   bitmap: The bitmap to draw.
+//   src_rect: Part of the bitmap to draw (a skin's atlas region), or NULL for all of it.
+//   dst_rect: Where to draw it on screen.
+//   color_mod: Color multiplied with the bitmap's own color (white leaves it unchanged).
+static inline void _draw_bitmap(VirtualJoystickTextureSet* set, const VirtualJoystickBitmap* bitmap, const SDL_Rect* src_rect,
+                                const SDL_Rect* dst_rect, SDL_Color color_mod) {
+    if (set->backend == JOYSTICK_BACKEND_GEOMETRY && !bitmap->pixels) {
+        SDL_Color color = {(Uint8)(bitmap->color.r * color_mod.r / 255), (Uint8)(bitmap->color.g * color_mod.g / 255),
+                           (Uint8)(bitmap->color.b * color_mod.b / 255), bitmap->color.a};
+        SDL_FPoint center = {dst_rect->x + dst_rect->w / 2.0f, dst_rect->y + dst_rect->h / 2.0f};
+        _draw_circle_geometry(set->renderer, center, dst_rect->w / 2.0f, color);
+        return;
+    }
+
+    SDL_Texture* texture = _get_bitmap_texture(set, bitmap);
+    if (!texture) return;
+    // Textures may be shared with other joysticks, so the color modulation is set on every draw.
+    SDL_SetTextureColorMod(texture, color_mod.r, color_mod.g, color_mod.b);
+    SDL_RenderCopy(set->renderer, texture, src_rect, dst_rect);
+}
+
+// --- Helper Function: _get_draw_sources ---
+// Returns what the joystick's base and tip are drawn from: the atlas page and region of a skin,
+// or the generated circle bitmap. The tip is tinted with pressed_color while a finger tracks
+// the joystick; otherwise circles use the default tip color and skins are left untinted.
+static inline void _get_draw_sources(const VirtualJoystick* joystick, const VirtualJoystickBitmap** base_bitmap, const SDL_Rect** base_src,
+                                     const VirtualJoystickBitmap** tip_bitmap, const SDL_Rect** tip_src, SDL_Color* tip_color) {
+    *base_bitmap = joystick->_base_skin ? &joystick->_base_skin->_page->bitmap : joystick->_base_bitmap;
+    *base_src = joystick->_base_skin ? &joystick->_base_skin->src_rect : NULL;
+    *tip_bitmap = joystick->_tip_skin ? &joystick->_tip_skin->_page->bitmap : joystick->_tip_bitmap;
+    *tip_src = joystick->_tip_skin ? &joystick->_tip_skin->src_rect : NULL;
+    if (joystick->_touch_index != -1) {
+        *tip_color = joystick->pressed_color;
+    } else {
+        *tip_color = joystick->_tip_skin ? (SDL_Color){255, 255, 255, 255} : joystick->_default_tip_color;
+    }
+}
+
+// --- Helper Function: _is_point_inside_joystick_area ---
+// Checks if a given point is within the overall interaction area of the joystick.
+static inline bool _is_point_inside_joystick_area(const VirtualJoystick* joystick, SDL_FPoint point) {
+    SDL_Point p = {(int)point.x, (int)point.y};
+    return SDL_PointInRect(&p, &joystick->joystick_area);
+}
+
+// --- Helper Function: _is_point_inside_base ---
+// Checks if a given point is within the circular base of the joystick.
+static inline bool _is_point_inside_base(const VirtualJoystick* joystick, SDL_FPoint point) {
+    float dx = point.x - joystick->_base_center.x;
+    float dy = point.y - joystick->_base_center.y;
+    return (dx * dx + dy * dy) <= (joystick->_base_radius * joystick->_base_radius);
+}
+
+// --- Helper Function: _move_base ---
+// Updates the center position of the joystick's base. The base is drawn there right away.
+static inline void _move_base(VirtualJoystick* joystick, SDL_FPoint new_center) {
+    joystick->_base_center = new_center;
+    joystick->_base_draw_center = new_center;
+    joystick->_base_velocity = (Vector2){0.0f, 0.0f};
+    joystick->_base_following = false;
+}
+
+// --- Helper Function: _follow_base ---
+// Moves the base after the finger in FOLLOWING mode. With a follow spring, the drawn base
+// catches up in VirtualJoystick_Update; output is always computed from the new position.
+static inline void _follow_base(VirtualJoystick* joystick, SDL_FPoint new_center) {
+    if (joystick->follow_spring_frequency <= 0.0f) {
+        _move_base(joystick, new_center);
+        return;
+    }
+    joystick->_base_center = new_center;
+    joystick->_base_following = true;
+}
+
+// --- Helper Function: _move_tip ---
+// Updates the center position of the joystick's tip. The tip is drawn there right away.
+static inline void _move_tip(VirtualJoystick* joystick, SDL_FPoint new_center) {
+    joystick->_tip_center = new_center;
+    joystick->_tip_draw_center = new_center;
+    joystick->_tip_velocity = (Vector2){0.0f, 0.0f};
+    joystick->_returning = false;
+}
+
+// --- Helper Function: _step_spring ---
+// Advances a critically damped spring by dt seconds with the exact closed-form solution, so it is
+// stable for any frame time and never overshoots its target.
+// Parameters:
+//   position: Current position, updated in place.
+//   velocity: Current velocity in pixels per second, updated in place.
+//   target: Position the spring pulls towards.
+//   frequency: Spring frequency in Hz.
+//   dt: Elapsed time in seconds.
+// Returns: true once the spring has come to rest on its target.
+static inline bool _step_spring(SDL_FPoint* position, Vector2* velocity, SDL_FPoint target, float frequency, float dt) {
+    float omega = 2.0f * 3.14159265f * frequency;
+    float decay = expf(-omega * dt);
+    Vector2 offset = {position->x - target.x, position->y - target.y};
+    Vector2 impulse = {velocity->x + omega * offset.x, velocity->y + omega * offset.y};
+    offset = (Vector2){(offset.x + impulse.x * dt) * decay, (offset.y + impulse.y * dt) * decay};
+    *velocity = (Vector2){(velocity->x - omega * impulse.x * dt) * decay, (velocity->y - omega * impulse.y * dt) * decay};
+
+    if (Vector2_Length(offset) < VIRTUAL_JOYSTICK_SPRING_REST_DISTANCE && Vector2_Length(*velocity) < VIRTUAL_JOYSTICK_SPRING_REST_SPEED) {
+        *position = target;
+        *velocity = (Vector2){0.0f, 0.0f};
+        return true;
+    }
+    *position = (SDL_FPoint){target.x + offset.x, target.y + offset.y};
+    return false;
+}
+
+// --- Helper Function: _spring_step_ms ---
+// Estimates how long a spring takes to move its drawn position by about one pixel, which is
+// as long as a host can wait before the next frame without the animation visibly stuttering.
+// A spring released from rest has no velocity yet, so the pull of its offset counts as well.
+// Returns: The step in milliseconds, between VIRTUAL_JOYSTICK_MIN_ANIMATION_STEP_MS and _MAX_ANIMATION_STEP_MS.
+static inline int _spring_step_ms(SDL_FPoint position, Vector2 velocity, SDL_FPoint target, float frequency) {
+    float omega = 2.0f * 3.14159265f * frequency;
+    Vector2 offset = {position.x - target.x, position.y - target.y};
+    float speed = fmaxf(Vector2_Length(velocity), omega * Vector2_Length(offset));
+    if (speed * VIRTUAL_JOYSTICK_MAX_ANIMATION_STEP_MS <= 1000.0f) return VIRTUAL_JOYSTICK_MAX_ANIMATION_STEP_MS;
+    int step_ms = (int)(1000.0f / speed);
+    return step_ms < VIRTUAL_JOYSTICK_MIN_ANIMATION_STEP_MS ? VIRTUAL_JOYSTICK_MIN_ANIMATION_STEP_MS : step_ms;
+}
+
+// --- Helper Function: _record_touch ---
+// Keeps the raw touch path for the debug overlay.
+static inline void _record_touch(VirtualJoystick* joystick, SDL_FPoint touch_position) {
+    if (!joystick->debug_overlay) return;
+    int index = (joystick->_touch_history_start + joystick->_touch_history_count) % VIRTUAL_JOYSTICK_TOUCH_HISTORY;
+    joystick->_touch_history[index] = touch_position;
+    if (joystick->_touch_history_count < VIRTUAL_JOYSTICK_TOUCH_HISTORY) {
+        joystick->_touch_history_count++;
+    } else {
+        joystick->_touch_history_start = (joystick->_touch_history_start + 1) % VIRTUAL_JOYSTICK_TOUCH_HISTORY;
+    }
+}
+
+// --- Helper Function: _deadzone_response ---
+// Maps a distance from the base center (or along one axis) to an output strength from 0 to 1.
+// Parameters:
+//   distance: The distance to map.
+//   deadzone: Distances up to this yield 0.
+//   saturation: Distances from this on yield 1.
+//   rescale: If true, output starts at 0 at the deadzone edge; otherwise it starts at deadzone / saturation.
+static inline float _deadzone_response(float distance, float deadzone, float saturation, bool rescale) {
+    float start = rescale ? deadzone : 0.0f;
+    float range = saturation - start;
+    if (distance <= deadzone || range <= 0.0f) return 0.0f; // Also prevents division by zero if clampzone <= deadzone.
+    return fminf((distance - start) / range, 1.0f);
+}
+
+// --- Helper Function: _apply_deadzone ---
+// Calculates the joystick's output and pressed state from the clamped vector between the base
+// center and the tip, using the joystick's deadzone shape, outer deadzone and axis snapping.
+static inline void _apply_deadzone(VirtualJoystick* joystick, Vector2 clamped_vector) {
+    float saturation = joystick->clampzone_size - joystick->outer_deadzone_size;
+    float deadzone = joystick->deadzone_size;
+    Vector2 output;
+
+    if (joystick->deadzone_shape == JOYSTICK_DEADZONE_AXIAL || joystick->deadzone_shape == JOYSTICK_DEADZONE_CROSS) {
+        bool rescale = joystick->deadzone_shape == JOYSTICK_DEADZONE_CROSS;
+        output.x = copysignf(_deadzone_response(fabsf(clamped_vector.x), deadzone, saturation, rescale), clamped_vector.x);
+        output.y = copysignf(_deadzone_response(fabsf(clamped_vector.y), deadzone, saturation, rescale), clamped_vector.y);
+        output = Vector2_LimitLength(output, 1.0f); // Diagonals would otherwise reach up to sqrt(2).
+        joystick->is_pressed = fabsf(clamped_vector.x) > deadzone || fabsf(clamped_vector.y) > deadzone;
+    } else {
+        float length = Vector2_Length(clamped_vector);
+        float strength = _deadzone_response(length, deadzone, saturation, joystick->deadzone_shape != JOYSTICK_DEADZONE_RADIAL);
+        Vector2 direction = Vector2_Normalize(clamped_vector);
+        output = (Vector2){direction.x * strength, direction.y * strength};
+        joystick->is_pressed = length > deadzone;
+    }
+
+    // Snap onto the nearest axis if the output is within snap_angle of it, keeping its strength.
+    if (joystick->snap_angle > 0.0f) {
+        if (joystick->_snap_tangent_angle != joystick->snap_angle) {
+            joystick->_snap_tangent = tanf(joystick->snap_angle * (3.14159265f / 180.0f));
+            joystick->_snap_tangent_angle = joystick->snap_angle;
+        }
+        float ax = fabsf(output.x);
+        float ay = fabsf(output.y);
+        if (fminf(ax, ay) <= joystick->_snap_tangent * fmaxf(ax, ay)) {
+            float length = Vector2_Length(output);
+            output = ax >= ay ? (Vector2){copysignf(length, output.x), 0.0f} : (Vector2){0.0f, copysignf(length, output.y)};
+        }
+    }
+
+    joystick->output = output;
+}
+
+// --- Helper Function: _update_joystick_logic ---
+// Contains the core logic for calculating joystick output and updating tip position
+// based on the current touch position.
+static inline void _update_joystick_logic(VirtualJoystick* joystick, SDL_FPoint touch_position) {
+    VIRTUAL_JOYSTICK_TRACE_BEGIN("update_joystick_logic");
+    _record_touch(joystick, touch_position);
+
+    // Calculate vector from base center to touch position.
+    Vector2 vector_from_base_center = (Vector2){touch_position.x - joystick->_base_center.x,
+                                                touch_position.y - joystick->_base_center.y};
+
+    // Limit the vector length to the clampzone_size.
+    Vector2 clamped_vector = Vector2_LimitLength(vector_from_base_center, joystick->clampzone_size);
+
+    // Handle FOLLOWING joystick mode: move the base if finger moves outside clampzone.
+    if (joystick->joystick_mode == JOYSTICK_MODE_FOLLOWING && Vector2_Length(vector_from_base_center) > joystick->clampzone_size) {
+        // Calculate new base center to keep the tip at the clampzone edge.
+        SDL_FPoint new_base_center = (SDL_FPoint){touch_position.x - clamped_vector.x,
+                                                  touch_position.y - clamped_vector.y};
+        _follow_base(joystick, new_base_center);
+    }
+
+    // Update tip position relative to the current base center.
+    _move_tip(joystick, (SDL_FPoint){joystick->_base_center.x + clamped_vector.x,
+                                     joystick->_base_center.y + clamped_vector.y});
+
+    // Calculate joystick output based on deadzone and clampzone.
+    _apply_deadzone(joystick, clamped_vector);
+    VIRTUAL_JOYSTICK_TRACE_END("update_joystick_logic");
+}
+
+// --- Helper Function: _update_relative_logic ---
+// RELATIVE mode: adds the finger's motion since the previous event to the summed delta, scaled
+// by the sensitivity and, with acceleration, by the finger's speed. The tip follows the finger
+// within the clampzone so the control still shows where it is being dragged.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance.
+//   touch_position: The finger position in pixels.
+//   timestamp: The event's timestamp in milliseconds.
+static inline void _update_relative_logic(VirtualJoystick* joystick, SDL_FPoint touch_position, Uint32 timestamp) {
+    VIRTUAL_JOYSTICK_TRACE_BEGIN("update_relative_logic");
+    _record_touch(joystick, touch_position);
+
+    Vector2 delta = {touch_position.x - joystick->_last_touch_position.x, touch_position.y - joystick->_last_touch_position.y};
+    Uint32 elapsed = timestamp - joystick->_last_touch_timestamp;
+    float speed = Vector2_Length(delta) / (float)(elapsed > 0 ? elapsed : 1);
+    float gain = joystick->relative_sensitivity * (1.0f + joystick->relative_acceleration * speed);
+    joystick->_relative_delta.x += delta.x * gain;
+    joystick->_relative_delta.y += delta.y * gain;
+    joystick->_last_touch_position = touch_position;
+    joystick->_last_touch_timestamp = timestamp;
+
+    Vector2 clamped_vector = Vector2_LimitLength((Vector2){touch_position.x - joystick->_base_center.x,
+                                                           touch_position.y - joystick->_base_center.y}, joystick->clampzone_size);
+    _move_tip(joystick, (SDL_FPoint){joystick->_base_center.x + clamped_vector.x, joystick->_base_center.y + clamped_vector.y});
+    VIRTUAL_JOYSTICK_TRACE_END("update_relative_logic");
+}
+
+// --- Helper Function: _park_joystick ---
+// Moves the base and tip back to their default position and hides the joystick.
+static inline void _park_joystick(VirtualJoystick* joystick) {
+    // Reset base and tip positions to their defaults.
+    _move_base(joystick, joystick->_base_default_center);
+    _move_tip(joystick, joystick->_base_default_center); // Tip goes back to base center.
+
+    joystick->_hidden = true; // Hide the joystick after release.
+}
+
+// --- Helper Function: _reset_joystick ---
+// Resets the joystick to its default, unpressed state. With a return spring, the output is reset
+// right away while the drawn tip springs back to the base (see VirtualJoystick_Update).
+static inline void _reset_joystick(VirtualJoystick* joystick) {
+    joystick->is_pressed = false;
+    joystick->output = (Vector2){0.0f, 0.0f};
+    joystick->_touch_index = -1; // No finger is currently touching (the tip is drawn in its default color again).
+
+    if (joystick->return_spring_frequency > 0.0f && !joystick->_hidden) {
+        // The base stays where it is drawn while the tip returns to it.
+        joystick->_base_center = joystick->_base_draw_center;
+        joystick->_tip_center = joystick->_base_draw_center;
+        joystick->_base_velocity = (Vector2){0.0f, 0.0f};
+        joystick->_base_following = false;
+        joystick->_returning = true;
+        return;
+    }
+
+    _park_joystick(joystick);
+}
+
+// --- Helper Function: _quantize_direction ---
+// Returns which of count equal sectors (0 = right, counting clockwise on screen) a vector points
+// into, or -1 for the zero vector or if count is not positive.
+static inline int _quantize_direction(Vector2 v, int count) {
+    if (count <= 0 || (v.x == 0.0f && v.y == 0.0f)) return -1;
+    float sector = 2.0f * 3.14159265f / count;
+    float angle = atan2f(v.y, v.x) + sector * 0.5f;
+    if (angle < 0.0f) angle += 2.0f * 3.14159265f;
+    return (int)(angle / sector) % count;
+}
+
+// --- Helper Function: _unqueue_change ---
+// Removes a joystick's pending record from the change queue.
+static inline void _unqueue_change(VirtualJoystick* joystick) {
+    int index = joystick->_queued_change;
+    if (index < 0) return;
+    _change_queue[index] = _change_queue[--_change_count];
+    if (index < _change_count) _change_queue[index].joystick->_queued_change = index;
+    joystick->_queued_change = -1;
+}
+
+// --- Helper Function: _report_changes ---
+// Emits a change record if the joystick's output moved by more than change_epsilon or its pressed
+// state or quantized direction changed since the last record. Records go to change_callback, or
+// are queued (merged with a still-pending record of the same joystick) if queue_changes is set.
+static inline void _report_changes(VirtualJoystick* joystick) {
+    if (!joystick->change_callback && !joystick->queue_changes) return;
+
+    Vector2 output = joystick->output;
+    Vector2 reported = joystick->_reported_output;
+    int direction = _quantize_direction(output, joystick->direction_count);
+    bool is_zero = output.x == 0.0f && output.y == 0.0f;
+    bool was_zero = reported.x == 0.0f && reported.y == 0.0f;
+    Uint32 flags = 0;
+    if (is_zero != was_zero || Vector2_Length((Vector2){output.x - reported.x, output.y - reported.y}) > joystick->change_epsilon) {
+        flags |= JOYSTICK_CHANGED_OUTPUT;
+    }
+    if (joystick->is_pressed != joystick->_reported_pressed) flags |= JOYSTICK_CHANGED_PRESSED;
+    if (direction != joystick->_reported_direction) flags |= JOYSTICK_CHANGED_DIRECTION;
+    if (!flags) return;
+
+    joystick->_reported_output = output;
+    joystick->_reported_pressed = joystick->is_pressed;
+    joystick->_reported_direction = direction;
+    VirtualJoystickChange change = {joystick, flags, output, joystick->is_pressed, direction};
+
+    if (joystick->change_callback) {
+        joystick->change_callback(&change, joystick->change_userdata);
+        return;
+    }
+    if (joystick->_queued_change >= 0) {
+        change.flags |= _change_queue[joystick->_queued_change].flags;
+        _change_queue[joystick->_queued_change] = change;
+        return;
+    }
+    if (_change_count == _change_capacity) {
+        int capacity = _change_capacity ? _change_capacity * 2 : 8;
+        VirtualJoystickChange* queue = (VirtualJoystickChange*)_joystick_realloc(_change_queue, (size_t)capacity * sizeof(*queue));
+        if (!queue) {
+            fprintf(stderr, "Failed to grow the joystick change queue\n");
+            return;
+        }
+        _change_queue = queue;
+        _change_capacity = capacity;
+    }
+    joystick->_queued_change = _change_count;
+    _change_queue[_change_count++] = change;
+}
+
+// --- Helper Function: _sync_device ---
+// Pushes the joystick's output and pressed state to its SDL virtual joystick device, touching
+// only the axes and button whose value changed.
+static inline void _sync_device(VirtualJoystick* joystick) {
+#if VIRTUAL_JOYSTICK_HAS_VIRTUAL_DEVICE
+    if (!joystick->_device) return;
+    Sint16 axes[2] = {(Sint16)(joystick->output.x * 32767.0f), (Sint16)(joystick->output.y * 32767.0f)};
+    for (int i = 0; i < 2; i++) {
+        if (axes[i] != joystick->_device_axes[i]) {
+            SDL_JoystickSetVirtualAxis(joystick->_device, joystick->_device_axis + i, axes[i]);
+            joystick->_device_axes[i] = axes[i];
+        }
+    }
+    if (joystick->is_pressed != joystick->_device_button) {
+        int button = joystick->_device_axis == SDL_CONTROLLER_AXIS_LEFTX ? SDL_CONTROLLER_BUTTON_LEFTSTICK : SDL_CONTROLLER_BUTTON_RIGHTSTICK;
+        SDL_JoystickSetVirtualButton(joystick->_device, button, joystick->is_pressed ? 1 : 0);
+        joystick->_device_button = joystick->is_pressed;
+    }
+#else
+    (void)joystick;
+#endif
+}
+
+// --- Helper Function: _publish_shared ---
+// Writes the joystick's state into its shared memory region, if it publishes one.
+static inline void _publish_shared(VirtualJoystick* joystick) {
+    VirtualJoystickSharedRegion* region = joystick->_shared;
+    if (!region) return;
+
+    VirtualJoystickSharedSample sample;
+    sample.timestamp = SDL_GetTicks();
+    sample.flags = (joystick->is_pressed ? JOYSTICK_SHARED_PRESSED : 0) | (joystick->_touch_index != -1 ? JOYSTICK_SHARED_ACTIVE : 0) |
+                   (!joystick->_hidden ? JOYSTICK_SHARED_VISIBLE : 0);
+    sample.output_x = joystick->output.x;
+    sample.output_y = joystick->output.y;
+    sample.base_x = joystick->_base_center.x;
+    sample.base_y = joystick->_base_center.y;
+    sample.tip_x = joystick->_tip_center.x;
+    sample.tip_y = joystick->_tip_center.y;
+
+    // Seqlock write: an odd sequence tells readers to retry.
+    region->sequence = region->sequence + 1;
+    SDL_MemoryBarrierRelease();
+    region->current = sample;
+    region->ring[region->write_count % VIRTUAL_JOYSTICK_SHARED_RING] = sample;
+    region->write_count = region->write_count + 1;
+    SDL_MemoryBarrierRelease();
+    region->sequence = region->sequence + 1;
+}
+
+// --- Helper Function: _finish_input ---
+// Passes the result of processed input on: change records, the virtual device and shared memory.
+static inline void _finish_input(VirtualJoystick* joystick) {
+    _report_changes(joystick);
+    _sync_device(joystick);
+    _publish_shared(joystick);
+}
+
+// --- Helper Function: _get_draw_rects ---
+// Calculates the on-screen destination rectangles of the joystick's base and tip.
+static inline void _get_draw_rects(const VirtualJoystick* joystick, SDL_Rect* base_dst_rect, SDL_Rect* tip_dst_rect) {
+    *base_dst_rect = (SDL_Rect){
+        (int)(joystick->_base_draw_center.x - joystick->_base_radius),
+        (int)(joystick->_base_draw_center.y - joystick->_base_radius),
+        joystick->_base_radius * 2,
+        joystick->_base_radius * 2
+    };
+    *tip_dst_rect = (SDL_Rect){
+        (int)(joystick->_tip_draw_center.x - joystick->_tip_radius),
+        (int)(joystick->_tip_draw_center.y - joystick->_tip_radius),
+        joystick->_tip_radius * 2,
+        joystick->_tip_radius * 2
+    };
+}
+
+// --- Helper Function: _invalidate_texture_sets ---
+// Marks every renderer's textures as lost. The restore happens lazily, once per renderer, on the
+// next draw, so it does not matter how many joysticks forward the same reset event.
+// Parameters:
+//   device_lost: true after SDL_RENDER_DEVICE_RESET (textures must be recreated), false after
+//                SDL_RENDER_TARGETS_RESET (the existing render-target textures only need re-uploading).
+static inline void _invalidate_texture_sets(bool device_lost) {
+    // HUD layers compare these counters to notice that their own target textures were lost.
+    if (device_lost) {
+        _device_resets++;
+    } else {
+        _target_resets++;
+    }
+    for (VirtualJoystickTextureSet* set = _texture_sets; set; set = set->next) {
+        if (device_lost) {
+            set->needs_recreate = true;
+        } else {
+            set->needs_upload = true;
+        }
+    }
+}
+
+
+// --- VirtualJoystick_Create ---
+// Initializes and allocates a new VirtualJoystick instance.
+// Parameters:
+//   renderer: The SDL_Renderer to be used for drawing the joystick.
+//   x, y: The top-left coordinates of the joystick's overall interaction area.
+//   width, height: The dimensions of the joystick's overall interaction area.
+//   window_width, window_height: The current dimensions of the window.
+// Returns: A pointer to the newly created VirtualJoystick on success, NULL on failure.
+VIRTUAL_JOYSTICK_API VirtualJoystick* VirtualJoystick_Create(SDL_Renderer* renderer, int x, int y, int width, int height, int window_width, int window_height) {
+    VirtualJoystick* joystick = (VirtualJoystick*)_joystick_malloc(sizeof(VirtualJoystick));
+    if (!joystick) {
+        fprintf(stderr, "Failed to allocate VirtualJoystick\n");
+        return NULL;
+    }
+    _joystick_count++;
+
+    joystick->renderer = renderer;
+    joystick->joystick_area = (SDL_Rect){x, y, width, height};
+    joystick->_window_width = window_width;
+    joystick->_window_height = window_height;
+
+    // Set default properties.
+    joystick->pressed_color = (SDL_Color){100, 100, 100, 180}; // Medium gray, semi-transparent
+    joystick->deadzone_size = 10.0f;
+    joystick->clampzone_size = 75.0f;
+    joystick->deadzone_shape = JOYSTICK_DEADZONE_SCALED_RADIAL;
+    joystick->outer_deadzone_size = 0.0f;
+    joystick->snap_angle = 0.0f;
+    joystick->_snap_tangent = 0.0f;
+    joystick->_snap_tangent_angle = 0.0f;
+    joystick->relative_sensitivity = 1.0f;
+    joystick->relative_acceleration = 0.0f;
+    joystick->return_spring_frequency = 0.0f;
+    joystick->follow_spring_frequency = 0.0f;
+    joystick->change_epsilon = 0.01f;
+    joystick->direction_count = 8;
+    joystick->change_callback = NULL;
+    joystick->change_userdata = NULL;
+    joystick->queue_changes = false;
+    joystick->joystick_mode = JOYSTICK_MODE_DYNAMIC; // Dynamic mode by default
+    joystick->z_order = 0;
+    joystick->debug_overlay = false;
+
+    joystick->is_pressed = false;
+    joystick->output = (Vector2){0.0f, 0.0f};
+    joystick->_touch_index = -1;
+    joystick->_pressed_keys = 0;
+    joystick->input_sources = JOYSTICK_INPUT_TOUCH | JOYSTICK_INPUT_CUSTOM;
+    joystick->_touch_history_start = 0;
+    joystick->_touch_history_count = 0;
+    joystick->_relative_delta = (Vector2){0.0f, 0.0f};
+    joystick->_last_touch_position = (SDL_FPoint){0.0f, 0.0f};
+    joystick->_last_touch_timestamp = 0;
+    joystick->_reported_output = (Vector2){0.0f, 0.0f};
+    joystick->_reported_pressed = false;
+    joystick->_reported_direction = -1;
+    joystick->_queued_change = -1;
+    joystick->_device = NULL;
+    joystick->_device_axis = SDL_CONTROLLER_AXIS_LEFTX;
+    joystick->_device_axes[0] = joystick->_device_axes[1] = 0;
+    joystick->_device_button = false;
+    joystick->_shared = NULL;
+    joystick->_shared_name = NULL;
+
+    // Calculate radii for base and tip based on the joystick area size.
+    joystick->_base_radius = (int)(fmin(width, height) * 0.25f);
+    joystick->_tip_radius = (int)(joystick->_base_radius * 0.6f);
+
+    joystick->_base_skin = NULL;
+    joystick->_tip_skin = NULL;
+
+    // Get the (possibly shared) bitmaps for the base and tip.
+    joystick->_default_tip_color = (SDL_Color){200, 200, 200, 180}; // Light gray, semi-transparent
+    joystick->_base_bitmap = _acquire_circle_bitmap(joystick->_base_radius, (SDL_Color){50, 50, 50, 180}, _antialias_samples); // Dark gray, semi-transparent
+    joystick->_tip_bitmap = _acquire_circle_bitmap(joystick->_tip_radius, joystick->_default_tip_color, _antialias_samples);
+
+    // Create the textures on the joystick's own renderer right away so failures surface here.
+    // Other renderers get theirs on the first draw.
+    VirtualJoystickTextureSet* set = _get_texture_set(renderer, true);
+    if (!joystick->_base_bitmap || !joystick->_tip_bitmap || !set ||
+        (set->backend != JOYSTICK_BACKEND_GEOMETRY &&
+         (!_get_bitmap_texture(set, joystick->_base_bitmap) || !_get_bitmap_texture(set, joystick->_tip_bitmap)))) {
+        VirtualJoystick_Destroy(joystick); // Clean up if texture creation fails.
+        return NULL;
+    }
+
+    // Set initial default positions for the base and tip.
+    joystick->_base_default_center = (SDL_FPoint){joystick->joystick_area.x + joystick->joystick_area.w / 2.0f,
+                                                  joystick->joystick_area.y + joystick->joystick_area.h / 2.0f};
+    _move_base(joystick, joystick->_base_default_center);
+    _move_tip(joystick, joystick->_base_center); // Initially, tip is at base center.
+
+    joystick->_hidden = true; // Joystick is hidden by default.
+
+    return joystick;
+}
+
+// --- VirtualJoystick_Destroy ---
+// Frees all resources associated with the VirtualJoystick.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance to destroy.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_Destroy(VirtualJoystick* joystick) {
+    if (joystick) {
+        _unqueue_change(joystick);
+        VirtualJoystick_DetachDevice(joystick);
+        VirtualJoystick_UnpublishShared(joystick);
+        // Textures are owned by the shared bitmaps and go away with their last user.
+        _release_bitmap(joystick->_base_bitmap);
+        _release_bitmap(joystick->_tip_bitmap);
+        if (joystick->_base_skin) joystick->_base_skin->_users--;
+        if (joystick->_tip_skin) joystick->_tip_skin->_users--;
+        VirtualJoystickSkin_Release(joystick->_base_skin);
+        VirtualJoystickSkin_Release(joystick->_tip_skin);
+        _joystick_free(joystick);
+
+        // Without joysticks nothing can be queued, so give the queue back (SetAllocator needs
+        // every allocation gone).
+        if (--_joystick_count == 0) {
+            _joystick_free(_change_queue);
+            _change_queue = NULL;
+            _change_count = 0;
+            _change_capacity = 0;
+        }
+    }
+}
+
+// --- VirtualJoystick_ReleaseRenderer ---
+// Frees every texture the joysticks created on a renderer. Call this before destroying a
+// renderer that joysticks were drawn to; drawing to it again would recreate the textures.
+// Without it, a later renderer that SDL allocates at the same address would be handed the dead
+// textures. That is only caught if the new renderer draws to another window.
+// Parameters:
+//   renderer: The SDL_Renderer that is about to be destroyed.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_ReleaseRenderer(SDL_Renderer* renderer) {
+    for (VirtualJoystickTextureSet** link = &_texture_sets; *link; link = &(*link)->next) {
+        VirtualJoystickTextureSet* set = *link;
+        if (set->renderer == renderer) {
+            *link = set->next;
+            _clear_texture_set(set);
+            _joystick_free(set->entries);
+            _joystick_free(set);
+            return;
+        }
+    }
+}
+
+// --- VirtualJoystick_SetRendererBackend ---
+// Overrides the backend chosen for a renderer, e.g. to compare backends. Existing textures on the
+// renderer are dropped and recreated with the new backend on the next draw. Renderers that were
+// only ever drawn to (never passed to VirtualJoystick_Create) use a default backend for their
+// type; pass JOYSTICK_BACKEND_AUTO here, outside of drawing, to time them.
+// Parameters:
+//   renderer: The SDL_Renderer to configure.
+//   backend: The backend to use, or JOYSTICK_BACKEND_AUTO to probe the renderer again.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_SetRendererBackend(SDL_Renderer* renderer, JoystickBackend backend) {
+    VirtualJoystickTextureSet* set = _find_texture_set(renderer, true);
+    if (!set) return;
+    _clear_texture_set(set);
+    if (backend == JOYSTICK_BACKEND_AUTO || backend >= JOYSTICK_BACKEND_COUNT ||
+        (backend == JOYSTICK_BACKEND_GEOMETRY && !VIRTUAL_JOYSTICK_HAS_GEOMETRY)) {
+        _init_texture_set(set);
+        _probe_renderer_backend(set);
+    } else {
+        set->backend = backend;
+        set->probed = true;
+    }
+}
+
+// --- VirtualJoystick_GetStats ---
+// Reports the backend chosen for a renderer and a few diagnostic counters.
+// Parameters:
+//   renderer: The SDL_Renderer to report on (may be NULL for global counters only).
+//   stats: Receives the statistics.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_GetStats(SDL_Renderer* renderer, VirtualJoystickStats* stats) {
+    SDL_memset(stats, 0, sizeof(*stats));
+    stats->backend = JOYSTICK_BACKEND_AUTO;
+    stats->texture_uploads = _texture_uploads;
+
+    VirtualJoystickTextureSet* set = renderer ? _find_texture_set(renderer, false) : NULL;
+    if (set) {
+        stats->backend = set->backend;
+        stats->premultiplied = set->premultiplied;
+        SDL_memcpy(stats->probe_ms, set->probe_ms, sizeof(stats->probe_ms));
+        stats->texture_count = set->count;
+    }
+    stats->layer_redraws = _layer_redraws;
+    stats->state_changes = _last_state_changes;
+    stats->prepare_ms = _last_prepare_ms;
+    stats->prepare_threads = _last_prepare_threads;
+}
+
+// --- VirtualJoystick_SetAllocator ---
+// Installs the functions used for all of the library's heap memory (SDL_malloc and friends by
+// default). Memory must be freed by the functions that allocated it, so this can only be called
+// while nothing is allocated: before creating the first joystick, or after everything is destroyed.
+// Parameters:
+//   malloc_func, calloc_func, realloc_func, free_func: The allocator, or all NULL for SDL's.
+// Returns: true on success, false if memory is still allocated or only some functions were given.
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_SetAllocator(SDL_malloc_func malloc_func, SDL_calloc_func calloc_func, SDL_realloc_func realloc_func, SDL_free_func free_func) {
+    bool all = malloc_func && calloc_func && realloc_func && free_func;
+    bool none = !malloc_func && !calloc_func && !realloc_func && !free_func;
+    if (!all && !none) {
+        fprintf(stderr, "Allocator hooks need all four functions (or none for the defaults)\n");
+        return false;
+    }
+    SDL_AtomicLock(&_memory_lock);
+    int live = _allocation_count;
+    SDL_AtomicUnlock(&_memory_lock);
+    if (live > 0) {
+        fprintf(stderr, "Cannot change the allocator while %d allocations are live\n", live);
+        return false;
+    }
+    _malloc_func = all ? malloc_func : SDL_malloc;
+    _calloc_func = all ? calloc_func : SDL_calloc;
+    _realloc_func = all ? realloc_func : SDL_realloc;
+    _free_func = all ? free_func : SDL_free;
+    return true;
+}
+
+// --- Helper Function: _add_shape_memory ---
+// Adds a joystick's share of a shared shape to its memory stats: the bytes of the bitmap (and its
+// textures on every renderer) divided by the number of joysticks using it, so the shares of all
+// joysticks add up to what the shapes use. Texture bytes follow each texture's pixel format.
+// Parameters:
+//   stats: The stats to add to.
+//   bitmap: Bitmap holding the shape (a circle, or a skin's atlas page).
+//   width, height: Size of the shape within the bitmap.
+//   heap_bytes: Heap bytes of the shape itself (0 if it does not own any).
+//   users: Number of joysticks sharing the shape.
+static inline void _add_shape_memory(VirtualJoystickMemoryStats* stats, const VirtualJoystickBitmap* bitmap,
+                                     int width, int height, size_t heap_bytes, int users) {
+    if (users < 1) users = 1;
+    stats->heap_bytes += heap_bytes / (size_t)users;
+    size_t bitmap_area = (size_t)bitmap->width * (size_t)bitmap->height;
+    if (bitmap_area == 0) return;
+    for (VirtualJoystickTextureSet* set = _texture_sets; set; set = set->next) {
+        for (int i = 0; i < set->count; i++) {
+            if (set->entries[i].bitmap != bitmap || !set->entries[i].texture) continue;
+            Uint32 format;
+            int texture_width, texture_height;
+            if (SDL_QueryTexture(set->entries[i].texture, &format, NULL, &texture_width, &texture_height) == 0) {
+                // A skin covers only part of its page's texture.
+                size_t texture_bytes = (size_t)texture_width * (size_t)texture_height * (size_t)SDL_BYTESPERPIXEL(format);
+                stats->texture_bytes += texture_bytes * ((size_t)width * (size_t)height) / bitmap_area / (size_t)users;
+            }
+            break;
+        }
+    }
+}
+
+// --- VirtualJoystick_GetMemoryStats ---
+// Reports heap and texture memory, in aggregate or for one joystick. A joystick is charged for
+// its own allocations plus its share of the bitmaps, skins and textures it uses with other
+// joysticks. Memory not owned by any joystick (HUD layers, draw lists, caches) only shows in the
+// aggregate.
+// Parameters:
+//   joystick: The joystick to report on, or NULL for the totals of the whole library.
+//   stats: Receives the statistics.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_GetMemoryStats(const VirtualJoystick* joystick, VirtualJoystickMemoryStats* stats) {
+    SDL_memset(stats, 0, sizeof(*stats));
+    if (!joystick) {
+        SDL_AtomicLock(&_memory_lock);
+        stats->heap_bytes = _heap_bytes;
+        stats->peak_heap_bytes = _peak_heap_bytes;
+        stats->allocation_count = _allocation_count;
+        stats->texture_bytes = _texture_bytes;
+        stats->texture_count = _texture_count;
+        SDL_AtomicUnlock(&_memory_lock);
+        return;
+    }
+
+    stats->heap_bytes = sizeof(VirtualJoystick);
+    stats->allocation_count = 1;
+    if (joystick->_shared_name) {
+        stats->heap_bytes += SDL_strlen(joystick->_shared_name) + 1;
+        stats->allocation_count++;
+    }
+    const VirtualJoystickBitmap* bitmaps[2] = {joystick->_base_bitmap, joystick->_tip_bitmap};
+    const VirtualJoystickSkin* skins[2] = {joystick->_base_skin, joystick->_tip_skin};
+    for (int i = 0; i < 2; i++) {
+        const VirtualJoystickBitmap* bitmap = bitmaps[i];
+        if (bitmap) {
+            size_t heap_bytes = sizeof(VirtualJoystickBitmap) + (bitmap->_mapped ? 0 : (size_t)bitmap->width * (size_t)bitmap->height);
+            // A prepared bitmap is pinned by an extra reference that is not a joystick.
+            _add_shape_memory(stats, bitmap, bitmap->width, bitmap->height, heap_bytes,
+                              bitmap->_refcount - (bitmap->_prepared ? 1 : 0));
+        }
+        const VirtualJoystickSkin* skin = skins[i];
+        if (skin) {
+            // The skin's pixels live on its atlas page; charge the part of the page it covers.
+            size_t heap_bytes = sizeof(VirtualJoystickSkin) + (size_t)skin->width * (size_t)skin->height * sizeof(Uint32);
+            _add_shape_memory(stats, &skin->_page->bitmap, skin->width, skin->height, heap_bytes, skin->_users);
+        }
+    }
+}
+
+// --- VirtualJoystick_StartTrace ---
+// Starts recording trace events (see Tracing). Call it once on the main thread before other
+// threads use joysticks. Needs the library to be compiled with VIRTUAL_JOYSTICK_TRACE set to 1.
+// Returns: true on success, false if tracing is compiled out or could not be started.
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_StartTrace(void) {
+#if VIRTUAL_JOYSTICK_TRACE
+    if (!_trace_tls) {
+        _trace_tls = SDL_TLSCreate();
+        if (!_trace_tls) {
+            fprintf(stderr, "Could not create thread-local storage for tracing: %s\n", SDL_GetError());
+            return false;
+        }
+        _trace_start = SDL_GetPerformanceCounter();
+    }
+    return true;
+#else
+    fprintf(stderr, "Tracing is not compiled in (define VIRTUAL_JOYSTICK_TRACE to 1)\n");
+    return false;
+#endif
+}
+
+// --- VirtualJoystick_WriteTrace ---
+// Writes the events recorded since the last write as a Chrome trace JSON file, then empties the
+// buffers. Events from other threads that are still running are written up to the last complete
+// one, but the buffers must not be emptied under them: call this while joysticks are not being
+// used on other threads (for example between frames, or at exit).
+// Parameters:
+//   path: File to write, e.g. "joystick_trace.json".
+// Returns: true on success, false on failure.
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_WriteTrace(const char* path) {
+#if VIRTUAL_JOYSTICK_TRACE
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Could not open trace file %s\n", path);
+        return false;
+    }
+    double microseconds_per_count = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    bool first = true;
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (VirtualJoystickTraceBuffer* buffer = (VirtualJoystickTraceBuffer*)SDL_AtomicGetPtr(&_trace_buffers); buffer; buffer = buffer->next) {
+        int count = SDL_AtomicGet(&buffer->count);
+        for (int i = 0; i < count; i++) {
+            const VirtualJoystickTraceEvent* event = &buffer->events[i];
+            fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"joystick\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%lu%s}",
+                    first ? "" : ",\n", event->name, event->phase, (double)(event->counter - _trace_start) * microseconds_per_count,
+                    (unsigned long)buffer->thread, event->phase == 'i' ? ",\"s\":\"t\"" : "");
+            first = false;
+        }
+        SDL_AtomicSet(&buffer->count, 0);
+    }
+    fprintf(file, "\n]}\n");
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    if (!ok) fprintf(stderr, "Could not write trace file %s\n", path);
+    return ok;
+#else
+    (void)path;
+    fprintf(stderr, "Tracing is not compiled in (define VIRTUAL_JOYSTICK_TRACE to 1)\n");
+    return false;
+#endif
+}
+
+// --- VirtualJoystickRasterJob Structure ---
+// Work shared by the rasterization threads of VirtualJoystick_PrepareBitmaps.
+typedef struct {
+    VirtualJoystickBitmap** bitmaps; // Bitmaps to rasterize (NULL entries are skipped).
+    const VirtualJoystickBitmapDesc* descs; // Shape of the bitmap at the same index.
+    int count;                     // Number of entries.
+    SDL_atomic_t next;             // Index of the next entry to claim.
+    SDL_atomic_t failures;         // Number of bitmaps that could not be rasterized.
+} VirtualJoystickRasterJob;
+
+// --- Helper Function: _raster_worker ---
+// Thread entry point: claims bitmaps one at a time and rasterizes them. Rasterization is pure
+// CPU work on memory owned by the job, so workers need no locking beyond the claim counter.
+static int _raster_worker(void* data) {
+    VirtualJoystickRasterJob* job = (VirtualJoystickRasterJob*)data;
+    for (;;) {
+        int index = SDL_AtomicAdd(&job->next, 1);
+        if (index >= job->count) break;
+        VirtualJoystickBitmap* bitmap = job->bitmaps[index];
+        if (bitmap && !_rasterize_circle_bitmap(bitmap, job->descs[index].radius, job->descs[index].color, job->descs[index].aa_samples)) {
+            SDL_AtomicAdd(&job->failures, 1);
+        }
+    }
+    return 0;
+}
+
+// --- VirtualJoystick_PrepareBitmaps ---
+// Generates circle bitmaps ahead of time on a small pool of worker threads, so creating many
+// joysticks at startup does not rasterize them one by one on the render thread. Bitmaps that
+// already exist are reused. Prepared bitmaps stay alive until VirtualJoystick_ReleasePreparedBitmaps.
+// Parameters:
+//   renderer: If not NULL, the textures are also created on this renderer. This is the only part
+//             that runs on the calling (render) thread; otherwise textures are created on first draw.
+//   descs: The bitmaps to generate.
+//   count: Number of entries in descs.
+//   thread_count: Number of worker threads; 0 or less uses one per CPU core.
+// Returns: true if every bitmap (and texture) was created, false otherwise.
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_PrepareBitmaps(SDL_Renderer* renderer, const VirtualJoystickBitmapDesc* descs, int count, int thread_count) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    // The statistics describe this call only, even if it returns early or has nothing to rasterize.
+    _last_prepare_ms = 0.0f;
+    _last_prepare_threads = 0;
+    if (count <= 0) return true;
+
+    VirtualJoystickRasterJob job;
+    job.bitmaps = (VirtualJoystickBitmap**)_joystick_calloc((size_t)count, sizeof(VirtualJoystickBitmap*));
+    if (!job.bitmaps) {
+        fprintf(stderr, "Failed to allocate bitmap preparation job\n");
+        return false;
+    }
+    job.descs = descs;
+    job.count = count;
+    SDL_AtomicSet(&job.next, 0);
+    SDL_AtomicSet(&job.failures, 0);
+
+    // Allocate the bitmaps to generate on this thread; only their pixels are filled in by workers.
+    bool ok = true;
+    int pending = 0;
+    for (int i = 0; i < count; i++) {
+        int aa_samples = _normalize_aa_samples(descs[i].aa_samples);
+        bool duplicate = _find_circle_bitmap(descs[i].radius, descs[i].color, aa_samples) != NULL;
+        VirtualJoystickBitmap* cached = duplicate ? NULL : _load_cached_bitmap(descs[i].radius, descs[i].color, aa_samples);
+        if (cached) {
+            // Loaded from the on-disk cache; it is pinned below like the others.
+            cached->_refcount = 0;
+            duplicate = true;
+        }
+        for (int j = 0; j < i && !duplicate; j++) {
+            duplicate = job.bitmaps[j] && descs[j].radius == descs[i].radius && SDL_memcmp(&descs[j].color, &descs[i].color, sizeof(SDL_Color)) == 0 &&
+                        _normalize_aa_samples(descs[j].aa_samples) == aa_samples;
+        }
+        if (duplicate) continue;
+        job.bitmaps[i] = (VirtualJoystickBitmap*)_joystick_malloc(sizeof(VirtualJoystickBitmap));
+        if (!job.bitmaps[i]) {
+            fprintf(stderr, "Failed to allocate circle bitmap\n");
+            ok = false;
+            break;
+        }
+        job.bitmaps[i]->alpha = NULL;
+        pending++;
+    }
+
+    if (ok && pending > 0) {
+        if (thread_count <= 0) thread_count = SDL_GetCPUCount();
+        if (thread_count > pending) thread_count = pending;
+        if (thread_count > 64) thread_count = 64;
+
+        // The calling thread works too, so one "thread" means no extra threads at all.
+        SDL_Thread* threads[64];
+        int started = 0;
+        for (int i = 1; i < thread_count; i++) {
+            threads[started] = SDL_CreateThread(_raster_worker, "VJRaster", &job);
+            if (threads[started]) started++;
+        }
+        _raster_worker(&job);
+        for (int i = 0; i < started; i++) {
+            SDL_WaitThread(threads[i], NULL);
+        }
+        _last_prepare_threads = started + 1;
+        ok = SDL_AtomicGet(&job.failures) == 0;
+    }
+
+    // Publish the generated bitmaps and pin every requested one until it is released.
+    for (int i = 0; i < count; i++) {
+        VirtualJoystickBitmap* bitmap = job.bitmaps[i];
+        if (bitmap && !bitmap->alpha) {
+            _joystick_free(bitmap); // Never rasterized (allocation failure); already counted in ok.
+            continue;
+        }
+        if (bitmap) {
+            _register_bitmap(bitmap);
+            bitmap->_refcount = 0;
+        } else {
+            bitmap = _find_circle_bitmap(descs[i].radius, descs[i].color, _normalize_aa_samples(descs[i].aa_samples));
+        }
+        if (!bitmap) continue;
+        if (!bitmap->_prepared) {
+            bitmap->_prepared = true;
+            bitmap->_refcount++;
+        }
+
+        // Uploading needs the renderer and stays on this thread.
+        if (renderer && ok) {
+            VirtualJoystickTextureSet* set = _get_texture_set(renderer, true);
+            ok = set && (set->backend == JOYSTICK_BACKEND_GEOMETRY || _get_bitmap_texture(set, bitmap));
+        }
+    }
+    _joystick_free(job.bitmaps);
+
+    _last_prepare_ms = (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    return ok;
+}
+
+// --- VirtualJoystick_ReleasePreparedBitmaps ---
+// Drops the references VirtualJoystick_PrepareBitmaps kept. Bitmaps no joystick uses are freed.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_ReleasePreparedBitmaps(void) {
+    VirtualJoystickBitmap* bitmap = _shared_bitmaps;
+    while (bitmap) {
+        VirtualJoystickBitmap* next = bitmap->_next;
+        if (bitmap->_prepared) {
+            bitmap->_prepared = false;
+            _release_bitmap(bitmap);
+        }
+        bitmap = next;
+    }
+}
+
+// --- VirtualJoystick_SetAntialiasing ---
+// Sets the anti-aliasing used for the bitmaps of joysticks created from now on.
+// Parameters:
+//   samples: Sub-samples per axis and pixel; 1 (the default) keeps hard edges.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_SetAntialiasing(int samples) {
+    _antialias_samples = _normalize_aa_samples(samples);
+}
+
+// --- VirtualJoystick_OpenBitmapCache ---
+// Opens an on-disk bitmap cache written by VirtualJoystick_SaveBitmapCache. While it is open,
+// bitmaps found in it are read straight from the (memory-mapped) file instead of being
+// rasterized; only the expansion to the renderer's pixel format happens at upload. A missing or
+// outdated file is not an error worth stopping for: the cache is simply not used and bitmaps are
+// generated as usual. Damaged entries are skipped and their bitmaps generated instead.
+// Parameters:
+//   path: Path of the cache file.
+// Returns: true if the cache was opened, false otherwise.
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_OpenBitmapCache(const char* path) {
+    VirtualJoystick_CloseBitmapCache();
+
+    const Uint8* data = NULL;
+    size_t size = 0;
+    bool mapped = false;
+#if VIRTUAL_JOYSTICK_HAS_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            data = (const Uint8*)mapping;
+            size = (size_t)info.st_size;
+            mapped = true;
+        }
+    }
+    close(fd);
+#endif
+    if (!data) {
+        // No mmap on this platform (or it failed): read the whole file instead.
+        SDL_RWops* file = SDL_RWFromFile(path, "rb");
+        if (!file) return false;
+        Sint64 file_size = SDL_RWsize(file);
+        Uint8* buffer = file_size > 0 ? (Uint8*)_joystick_malloc((size_t)file_size) : NULL;
+        if (buffer && SDL_RWread(file, buffer, 1, (size_t)file_size) == (size_t)file_size) {
+            data = buffer;
+            size = (size_t)file_size;
+        } else {
+            _joystick_free(buffer);
+        }
+        SDL_RWclose(file);
+        if (!data) return false;
+    }
+
+    _bitmap_cache.data = data;
+    _bitmap_cache.size = size;
+    _bitmap_cache.mapped = mapped;
+
+    // Validate the header and entry table; single entries are checked when they are looked up.
+    const VirtualJoystickCacheHeader* header = (const VirtualJoystickCacheHeader*)data;
+    bool valid = size >= sizeof(VirtualJoystickCacheHeader) && SDL_memcmp(header->magic, VIRTUAL_JOYSTICK_CACHE_MAGIC, 8) == 0 &&
+                 header->version == VIRTUAL_JOYSTICK_CACHE_VERSION && header->byte_order == VIRTUAL_JOYSTICK_CACHE_BYTE_ORDER &&
+                 header->entry_count <= (size - sizeof(VirtualJoystickCacheHeader)) / sizeof(VirtualJoystickCacheEntry);
+    if (!valid) {
+        fprintf(stderr, "Ignoring invalid or outdated bitmap cache: %s\n", path);
+        VirtualJoystick_CloseBitmapCache();
+        return false;
+    }
+    _bitmap_cache.entries = (const VirtualJoystickCacheEntry*)(data + sizeof(VirtualJoystickCacheHeader));
+    _bitmap_cache.entry_count = header->entry_count;
+
+    int invalid_entries = 0;
+    for (Uint32 i = 0; i < _bitmap_cache.entry_count; i++) {
+        if (!_is_cache_entry_valid(&_bitmap_cache.entries[i])) invalid_entries++;
+    }
+    if (invalid_entries > 0) {
+        fprintf(stderr, "Skipping %d invalid entries of bitmap cache: %s\n", invalid_entries, path);
+    }
+    return true;
+}
+
+// --- VirtualJoystick_SaveBitmapCache ---
+// Writes every bitmap currently in use (or prepared) to an on-disk cache file for the next
+// launch. The file is written next to the target and renamed over it, so an open cache stays
+// valid until it is closed.
+// Parameters:
+//   path: Path of the cache file.
+// Returns: true on success, false on failure.
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_SaveBitmapCache(const char* path) {
+    Uint32 count = 0;
+    for (VirtualJoystickBitmap* bitmap = _shared_bitmaps; bitmap; bitmap = bitmap->_next) {
+        count++;
+    }
+
+    size_t path_length = SDL_strlen(path);
+    char* temp_path = (char*)_joystick_malloc(path_length + 5);
+    if (!temp_path) return false;
+    SDL_memcpy(temp_path, path, path_length);
+    SDL_memcpy(temp_path + path_length, ".tmp", 5);
+
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to write bitmap cache: %s\n", temp_path);
+        _joystick_free(temp_path);
+        return false;
+    }
+
+    VirtualJoystickCacheHeader header;
+    SDL_memset(&header, 0, sizeof(header));
+    SDL_memcpy(header.magic, VIRTUAL_JOYSTICK_CACHE_MAGIC, 8);
+    header.version = VIRTUAL_JOYSTICK_CACHE_VERSION;
+    header.byte_order = VIRTUAL_JOYSTICK_CACHE_BYTE_ORDER;
+    header.entry_count = count;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // Entries first, then each bitmap's alpha data padded to 4 bytes.
+    Uint32 offset = (Uint32)(sizeof(header) + count * sizeof(VirtualJoystickCacheEntry));
+    for (VirtualJoystickBitmap* bitmap = _shared_bitmaps; ok && bitmap; bitmap = bitmap->_next) {
+        VirtualJoystickCacheEntry entry;
+        SDL_memset(&entry, 0, sizeof(entry));
+        entry.radius = bitmap->width / 2;
+        entry.color[0] = bitmap->color.r;
+        entry.color[1] = bitmap->color.g;
+        entry.color[2] = bitmap->color.b;
+        entry.color[3] = bitmap->color.a;
+        entry.aa_samples = bitmap->aa_samples;
+        entry.offset = offset;
+        ok = fwrite(&entry, sizeof(entry), 1, file) == 1;
+        offset += ((Uint32)(bitmap->width * bitmap->height) + 3u) & ~3u;
+    }
+    static const Uint8 padding[4] = {0, 0, 0, 0};
+    for (VirtualJoystickBitmap* bitmap = _shared_bitmaps; ok && bitmap; bitmap = bitmap->_next) {
+        size_t bytes = (size_t)bitmap->width * (size_t)bitmap->height;
+        ok = fwrite(bitmap->alpha, 1, bytes, file) == bytes;
+        size_t pad = ((bytes + 3) & ~(size_t)3) - bytes;
+        if (ok && pad) ok = fwrite(padding, 1, pad, file) == pad;
+    }
+
+    ok = fclose(file) == 0 && ok;
+#if !VIRTUAL_JOYSTICK_HAS_MMAP
+    if (ok) remove(path); // rename() does not replace existing files everywhere.
+#endif
+    ok = ok && rename(temp_path, path) == 0;
+    if (!ok) {
+        fprintf(stderr, "Failed to write bitmap cache: %s\n", path);
+        remove(temp_path);
+    }
+    _joystick_free(temp_path);
+    return ok;
+}
+
+// --- VirtualJoystick_CloseBitmapCache ---
+// Closes the on-disk bitmap cache. Bitmaps still using pixels from the file get their own copy first.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_CloseBitmapCache(void) {
+    if (!_bitmap_cache.data) return;
+
+    // No new lookups from here on, even if the file has to stay open below.
+    _bitmap_cache.entry_count = 0;
+    for (VirtualJoystickBitmap* bitmap = _shared_bitmaps; bitmap; bitmap = bitmap->_next) {
+        if (!bitmap->_mapped) continue;
+        size_t bytes = (size_t)bitmap->width * (size_t)bitmap->height;
+        Uint8* copy = (Uint8*)_joystick_malloc(bytes);
+        if (!copy) {
+            // Bitmaps still point into the file, so it cannot be released yet.
+            fprintf(stderr, "Failed to detach bitmaps from the bitmap cache\n");
+            return;
+        }
+        SDL_memcpy(copy, bitmap->alpha, bytes);
+        bitmap->alpha = copy;
+        bitmap->_mapped = false;
+    }
+
+#if VIRTUAL_JOYSTICK_HAS_MMAP
+    if (_bitmap_cache.mapped) {
+        munmap((void*)_bitmap_cache.data, _bitmap_cache.size);
+    } else
+#endif
+    {
+        _joystick_free((void*)_bitmap_cache.data);
+    }
+    SDL_memset(&_bitmap_cache, 0, sizeof(_bitmap_cache));
+}
+
+// --- Helper Function: _skyline_fit ---
+// Checks where a width x height rectangle would sit if placed at skyline segment index.
+// Returns: The y coordinate it would be placed at, or -1 if it does not fit there.
+static inline int _skyline_fit(const VirtualJoystickAtlasPage* page, int index, int width, int height) {
+    int x = page->skyline[index].x;
+    if (x + width > page->bitmap.width) return -1;
+    int y = 0;
+    int remaining = width;
+    for (int i = index; remaining > 0; i++) {
+        if (page->skyline[i].y > y) y = page->skyline[i].y;
+        if (y + height > page->bitmap.height) return -1;
+        remaining -= page->skyline[i].width;
+    }
+    return y;
+}
+
+// --- Helper Function: _skyline_pack ---
+// Finds room for a rectangle on an atlas page with the skyline bottom-left heuristic (lowest
+// resulting top edge, then leftmost) and raises the skyline over it.
+// Returns: true and the position in out_x/out_y, or false if the page is full.
+static inline bool _skyline_pack(VirtualJoystickAtlasPage* page, int width, int height, int* out_x, int* out_y) {
+    int best_index = -1;
+    int best_x = 0;
+    int best_y = 0;
+    for (int i = 0; i < page->skyline_count; i++) {
+        int y = _skyline_fit(page, i, width, height);
+        if (y >= 0 && (best_index < 0 || y < best_y || (y == best_y && page->skyline[i].x < best_x))) {
+            best_index = i;
+            best_x = page->skyline[i].x;
+            best_y = y;
+        }
+    }
+    if (best_index < 0) return false;
+
+    // A skyline never has more segments than the page is wide, so the array cannot overflow.
+    VirtualJoystickSkylineNode node = {best_x, best_y + height, width};
+    SDL_memmove(&page->skyline[best_index + 1], &page->skyline[best_index], (size_t)(page->skyline_count - best_index) * sizeof(node));
+    page->skyline[best_index] = node;
+    page->skyline_count++;
+
+    // Trim or drop the segments now covered by the new one.
+    for (int i = best_index + 1; i < page->skyline_count; i++) {
+        int covered = node.x + node.width - page->skyline[i].x;
+        if (covered <= 0) break;
+        if (covered < page->skyline[i].width) {
+            page->skyline[i].x += covered;
+            page->skyline[i].width -= covered;
+            break;
+        }
+        SDL_memmove(&page->skyline[i], &page->skyline[i + 1], (size_t)(page->skyline_count - i - 1) * sizeof(node));
+        page->skyline_count--;
+        i--;
+    }
+    // Merge neighbours at the same height.
+    for (int i = 0; i + 1 < page->skyline_count; i++) {
+        if (page->skyline[i].y == page->skyline[i + 1].y) {
+            page->skyline[i].width += page->skyline[i + 1].width;
+            SDL_memmove(&page->skyline[i + 1], &page->skyline[i + 2], (size_t)(page->skyline_count - i - 2) * sizeof(node));
+            page->skyline_count--;
+            i--;
+        }
+    }
+
+    *out_x = best_x;
+    *out_y = best_y;
+    return true;
+}
+
+// --- Helper Function: _create_atlas_page ---
+// Creates an empty (transparent) atlas page of the given size.
+// Returns: The new page, or NULL on failure.
+static inline VirtualJoystickAtlasPage* _create_atlas_page(int width, int height) {
+    VirtualJoystickAtlasPage* page = (VirtualJoystickAtlasPage*)_joystick_calloc(1, sizeof(VirtualJoystickAtlasPage));
+    if (!page) return NULL;
+    page->bitmap.width = width;
+    page->bitmap.height = height;
+    page->bitmap.color = (SDL_Color){255, 255, 255, 255};
+    page->bitmap.aa_samples = 1;
+    page->bitmap.pixels = (Uint32*)_joystick_calloc((size_t)width * (size_t)height, sizeof(Uint32));
+    page->skyline = (VirtualJoystickSkylineNode*)_joystick_malloc((size_t)width * sizeof(VirtualJoystickSkylineNode));
+    if (!page->bitmap.pixels || !page->skyline) {
+        fprintf(stderr, "Failed to allocate skin atlas page\n");
+        _joystick_free(page->bitmap.pixels);
+        _joystick_free(page->skyline);
+        _joystick_free(page);
+        return NULL;
+    }
+    page->skyline[0] = (VirtualJoystickSkylineNode){0, 0, width};
+    page->skyline_count = 1;
+    page->next = _atlas_pages;
+    _atlas_pages = page;
+    return page;
+}
+
+// --- Helper Function: _destroy_atlas_page ---
+// Frees an atlas page and its textures on every renderer.
+static inline void _destroy_atlas_page(VirtualJoystickAtlasPage* page) {
+    _evict_bitmap_textures(&page->bitmap);
+    for (VirtualJoystickAtlasPage** link = &_atlas_pages; *link; link = &(*link)->next) {
+        if (*link == page) {
+            *link = page->next;
+            break;
+        }
+    }
+    _joystick_free(page->bitmap.pixels);
+    _joystick_free(page->skyline);
+    _joystick_free(page);
+}
+
+// --- Helper Function: _hash_pixels ---
+// FNV-1a hash of an image's size and pixels, used to find duplicate skins quickly.
+static inline Uint32 _hash_pixels(const Uint32* pixels, int width, int height, int pitch) {
+    Uint32 hash = 2166136261u;
+    hash = (hash ^ (Uint32)width) * 16777619u;
+    hash = (hash ^ (Uint32)height) * 16777619u;
+    for (int y = 0; y < height; y++) {
+        const Uint32* row = pixels + (size_t)y * (size_t)pitch;
+        for (int x = 0; x < width; x++) {
+            hash = (hash ^ row[x]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+// --- Helper Function: _create_skin ---
+// Adds an image to the skin atlas, or returns the existing skin with identical pixels.
+// Parameters:
+//   pixels: SDL_PIXELFORMAT_RGBA8888 pixels with straight alpha.
+//   width, height: Size of the image.
+//   pitch: Distance between rows, in pixels.
+// Returns: The skin with its reference count increased, or NULL on failure.
+static inline VirtualJoystickSkin* _create_skin(const Uint32* pixels, int width, int height, int pitch) {
+    if (width <= 0 || height <= 0) return NULL;
+
+    Uint32 hash = _hash_pixels(pixels, width, height, pitch);
+    for (VirtualJoystickSkin* skin = _skins; skin; skin = skin->_next) {
+        if (skin->_hash != hash || skin->width != width || skin->height != height) continue;
+        const VirtualJoystickBitmap* page = &skin->_page->bitmap;
+        bool same = true;
+        for (int y = 0; y < height && same; y++) {
+            same = SDL_memcmp(page->pixels + (size_t)(skin->src_rect.y + y) * (size_t)page->width + skin->src_rect.x,
+                              pixels + (size_t)y * (size_t)pitch, (size_t)width * sizeof(Uint32)) == 0;
+        }
+        if (same) {
+            skin->_refcount++;
+            return skin;
+        }
+    }
+
+    // Allocate the skin first: space packed into a page cannot be given back.
+    VirtualJoystickSkin* skin = (VirtualJoystickSkin*)_joystick_malloc(sizeof(VirtualJoystickSkin));
+    if (!skin) {
+        fprintf(stderr, "Failed to allocate VirtualJoystickSkin\n");
+        return NULL;
+    }
+
+    // Try the existing pages first; images too big for a page get a page of their own.
+    int padded_width = width + VIRTUAL_JOYSTICK_ATLAS_PADDING;
+    int padded_height = height + VIRTUAL_JOYSTICK_ATLAS_PADDING;
+    VirtualJoystickAtlasPage* page = NULL;
+    int x = 0, y = 0;
+    for (VirtualJoystickAtlasPage* candidate = _atlas_pages; candidate && !page; candidate = candidate->next) {
+        if (_skyline_pack(candidate, padded_width, padded_height, &x, &y)) page = candidate;
+    }
+    if (!page) {
+        int page_width = padded_width > VIRTUAL_JOYSTICK_ATLAS_SIZE ? padded_width : VIRTUAL_JOYSTICK_ATLAS_SIZE;
+        int page_height = padded_height > VIRTUAL_JOYSTICK_ATLAS_SIZE ? padded_height : VIRTUAL_JOYSTICK_ATLAS_SIZE;
+        page = _create_atlas_page(page_width, page_height);
+        if (!page || !_skyline_pack(page, padded_width, padded_height, &x, &y)) {
+            if (page) _destroy_atlas_page(page); // Never leave an empty page behind.
+            _joystick_free(skin);
+            return NULL;
+        }
+    }
+
+    for (int row = 0; row < height; row++) {
+        SDL_memcpy(page->bitmap.pixels + (size_t)(y + row) * (size_t)page->bitmap.width + x,
+                   pixels + (size_t)row * (size_t)pitch, (size_t)width * sizeof(Uint32));
+    }
+    page->skin_count++;
+
+    skin->width = width;
+    skin->height = height;
+    skin->src_rect = (SDL_Rect){x, y, width, height};
+    page->bitmap.version++;
+    _update_bitmap_textures(&page->bitmap, &skin->src_rect);
+    skin->_page = page;
+    skin->_hash = hash;
+    skin->_refcount = 1;
+    skin->_users = 0;
+    skin->_next = _skins;
+    _skins = skin;
+    return skin;
+}
+
+// --- VirtualJoystickSkin_LoadBMP ---
+// Loads a BMP image as a skin.
+// Parameters:
+//   path: Path of the BMP file.
+// Returns: The skin (release it with VirtualJoystickSkin_Release), or NULL on failure.
+VIRTUAL_JOYSTICK_API VirtualJoystickSkin* VirtualJoystickSkin_LoadBMP(const char* path) {
+    SDL_Surface* loaded = SDL_LoadBMP(path);
+    if (!loaded) {
+        fprintf(stderr, "Failed to load skin %s: %s\n", path, SDL_GetError());
+        return NULL;
+    }
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA8888, 0);
+    SDL_FreeSurface(loaded);
+    if (!converted) {
+        fprintf(stderr, "Failed to convert skin %s: %s\n", path, SDL_GetError());
+        return NULL;
+    }
+
+    SDL_LockSurface(converted);
+    VirtualJoystickSkin* skin = _create_skin((const Uint32*)converted->pixels, converted->w, converted->h, converted->pitch / (int)sizeof(Uint32));
+    SDL_UnlockSurface(converted);
+    SDL_FreeSurface(converted);
+    return skin;
+}
+
+// --- VirtualJoystickSkin_CreateFromRGBA ---
+// Creates a skin from raw pixels.
+// Parameters:
+//   rgba: Pixels as bytes in R, G, B, A order with straight (non-premultiplied) alpha.
+//   width, height: Size of the image.
+//   pitch: Distance between rows in bytes (width * 4 for tightly packed pixels).
+// Returns: The skin (release it with VirtualJoystickSkin_Release), or NULL on failure.
+VIRTUAL_JOYSTICK_API VirtualJoystickSkin* VirtualJoystickSkin_CreateFromRGBA(const Uint8* rgba, int width, int height, int pitch) {
+    if (width <= 0 || height <= 0) return NULL;
+    Uint32* pixels = (Uint32*)_joystick_malloc((size_t)width * (size_t)height * sizeof(Uint32));
+    if (!pixels) {
+        fprintf(stderr, "Failed to allocate skin pixels\n");
+        return NULL;
+    }
+    for (int y = 0; y < height; y++) {
+        const Uint8* src = rgba + (size_t)y * (size_t)pitch;
+        for (int x = 0; x < width; x++, src += 4) {
+            pixels[y * width + x] = ((Uint32)src[0] << 24) | ((Uint32)src[1] << 16) | ((Uint32)src[2] << 8) | src[3];
+        }
+    }
+    VirtualJoystickSkin* skin = _create_skin(pixels, width, height, width);
+    _joystick_free(pixels);
+    return skin;
+}
+
+// --- VirtualJoystickSkin_Release ---
+// Drops a reference to a skin. Joysticks keep their own references, so a skin can be released
+// right after it was assigned with VirtualJoystick_SetSkin. An atlas page is freed together
+// with its last skin.
+VIRTUAL_JOYSTICK_API void VirtualJoystickSkin_Release(VirtualJoystickSkin* skin) {
+    if (!skin || --skin->_refcount > 0) return;
+
+    for (VirtualJoystickSkin** link = &_skins; *link; link = &(*link)->_next) {
+        if (*link == skin) {
+            *link = skin->_next;
+            break;
+        }
+    }
+    VirtualJoystickAtlasPage* page = skin->_page;
+    _joystick_free(skin);
+    if (--page->skin_count == 0) _destroy_atlas_page(page);
+}
+
+// --- VirtualJoystick_SetSkin ---
+// Draws a joystick's base and tip with images instead of generated circles. Each image is
+// scaled to the size of the circle it replaces.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance.
+//   base_skin: Image for the base, or NULL for the generated circle.
+//   tip_skin: Image for the tip, or NULL for the generated circle.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_SetSkin(VirtualJoystick* joystick, VirtualJoystickSkin* base_skin, VirtualJoystickSkin* tip_skin) {
+    if (base_skin) {
+        base_skin->_refcount++;
+        base_skin->_users++;
+    }
+    if (tip_skin) {
+        tip_skin->_refcount++;
+        tip_skin->_users++;
+    }
+    if (joystick->_base_skin) joystick->_base_skin->_users--;
+    if (joystick->_tip_skin) joystick->_tip_skin->_users--;
+    VirtualJoystickSkin_Release(joystick->_base_skin);
+    VirtualJoystickSkin_Release(joystick->_tip_skin);
+    joystick->_base_skin = base_skin;
+    joystick->_tip_skin = tip_skin;
+}
+
+// --- VirtualJoystick_SetWindowSize ---
+// Updates the stored window dimensions within the joystick.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance.
+//   width: The new width of the window.
+//   height: The new height of the window.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_SetWindowSize(VirtualJoystick* joystick, int width, int height) {
+    if (joystick) {
+        joystick->_window_width = width;
+        joystick->_window_height = height;
+    }
+}
+
+// --- Helper Function: _begin_touch ---
+// Starts tracking a finger that touched down, without checking where it landed (the caller
+// decides which joystick a finger belongs to).
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance (not tracking another finger).
+//   sample: The JOYSTICK_TOUCH_DOWN sample.
+static inline void _begin_touch(VirtualJoystick* joystick, const VirtualJoystickTouchSample* sample) {
+    SDL_FPoint touch_pos = {sample->x, sample->y};
+    // In DYNAMIC/FOLLOWING/RELATIVE mode, move the base to the touch position.
+    if (joystick->joystick_mode != JOYSTICK_MODE_FIXED) {
+        _move_base(joystick, touch_pos);
+    }
+    VIRTUAL_JOYSTICK_TRACE_INSTANT("finger_down");
+    joystick->_touch_index = sample->finger_id; // Start tracking this finger.
+    joystick->_touch_history_count = 0; // The debug overlay shows the path of the current touch only.
+    joystick->_hidden = false; // Make the joystick visible (the tip is drawn in pressed_color while tracked).
+    if (joystick->joystick_mode == JOYSTICK_MODE_RELATIVE) {
+        // Motion is measured from here; touching down adds no delta of its own.
+        joystick->is_pressed = true;
+        joystick->_last_touch_position = touch_pos;
+        joystick->_last_touch_timestamp = sample->timestamp;
+        _update_relative_logic(joystick, touch_pos, sample->timestamp);
+    } else {
+        _update_joystick_logic(joystick, touch_pos); // Update joystick state immediately.
+    }
+}
+
+// --- Helper Function: _process_sample ---
+// The joystick core: updates the joystick from one touch sample, whatever source it came from.
+static inline void _process_sample(VirtualJoystick* joystick, const VirtualJoystickTouchSample* sample) {
+    // If the joystick is hidden, only process touches going down to make it appear.
+    if (joystick->_hidden && sample->phase != JOYSTICK_TOUCH_DOWN) return;
+
+    SDL_FPoint touch_pos = {sample->x, sample->y};
+    switch (sample->phase) {
+        case JOYSTICK_TOUCH_DOWN: {
+            // Check if the touch is within the joystick's interaction area and no other finger is tracking it.
+            if (_is_point_inside_joystick_area(joystick, touch_pos) && joystick->_touch_index == -1) {
+                bool should_activate = false;
+                if (joystick->joystick_mode != JOYSTICK_MODE_FIXED) {
+                    should_activate = true;
+                } else if (joystick->joystick_mode == JOYSTICK_MODE_FIXED && _is_point_inside_base(joystick, touch_pos)) {
+                    should_activate = true;
+                }
+
+                if (should_activate) {
+                    _begin_touch(joystick, sample);
+                }
+            }
+            break;
+        }
+        case JOYSTICK_TOUCH_UP: {
+            // If the released finger is the one tracking the joystick, reset the joystick.
+            if (sample->finger_id == joystick->_touch_index) {
+                VIRTUAL_JOYSTICK_TRACE_INSTANT("finger_up");
+                _reset_joystick(joystick);
+            }
+            break;
+        }
+        case JOYSTICK_TOUCH_MOVE: {
+            // If the moving finger is the one tracking the joystick, update its state.
+            if (sample->finger_id == joystick->_touch_index) {
+                if (joystick->joystick_mode == JOYSTICK_MODE_RELATIVE) {
+                    _update_relative_logic(joystick, touch_pos, sample->timestamp);
+                } else {
+                    _update_joystick_logic(joystick, touch_pos);
+                }
+            }
+            break;
+        }
+    }
+}
+
+// --- Helper Function: _convert_touch_event ---
+// Converts an SDL_FINGER* event to a touch sample in window pixels.
+// Returns: 1 if the event was a touch event, 0 otherwise.
+static inline int _convert_touch_event(const SDL_Event* event, int window_width, int window_height, VirtualJoystickTouchSample* samples) {
+    if (event->type != SDL_FINGERDOWN && event->type != SDL_FINGERUP && event->type != SDL_FINGERMOTION) return 0;
+    samples[0].phase = event->type == SDL_FINGERDOWN ? JOYSTICK_TOUCH_DOWN : event->type == SDL_FINGERUP ? JOYSTICK_TOUCH_UP : JOYSTICK_TOUCH_MOVE;
+    samples[0].finger_id = event->tfinger.fingerId;
+    samples[0].x = (float)event->tfinger.x * window_width;
+    samples[0].y = (float)event->tfinger.y * window_height;
+    samples[0].timestamp = event->tfinger.timestamp;
+    return 1;
+}
+
+// --- Helper Function: _touch_source ---
+// Input source for SDL_FINGER* events: converts normalized touch coordinates (0.0 to 1.0) to
+// window pixels.
+static int _touch_source(VirtualJoystick* joystick, const SDL_Event* event, VirtualJoystickTouchSample* samples) {
+    return _convert_touch_event(event, joystick->_window_width, joystick->_window_height, samples);
+}
+
+// --- Helper Function: _mouse_source ---
+// Input source for the mouse: dragging with the left button acts like a finger. Mouse events SDL
+// synthesizes from touches are skipped, since the touch source already handles those touches.
+static int _mouse_source(VirtualJoystick* joystick, const SDL_Event* event, VirtualJoystickTouchSample* samples) {
+    (void)joystick;
+    switch (event->type) {
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            if (event->button.which == SDL_TOUCH_MOUSEID || event->button.button != SDL_BUTTON_LEFT) return 0;
+            samples[0].phase = event->type == SDL_MOUSEBUTTONDOWN ? JOYSTICK_TOUCH_DOWN : JOYSTICK_TOUCH_UP;
+            samples[0].x = (float)event->button.x;
+            samples[0].y = (float)event->button.y;
+            break;
+        case SDL_MOUSEMOTION:
+            if (event->motion.which == SDL_TOUCH_MOUSEID || !(event->motion.state & SDL_BUTTON_LMASK)) return 0;
+            samples[0].phase = JOYSTICK_TOUCH_MOVE;
+            samples[0].x = (float)event->motion.x;
+            samples[0].y = (float)event->motion.y;
+            break;
+        default:
+            return 0;
+    }
+    samples[0].finger_id = VIRTUAL_JOYSTICK_MOUSE_FINGER;
+    samples[0].timestamp = event->common.timestamp;
+    return 1;
+}
+
+// --- Helper Function: _keyboard_source ---
+// Input source for the keyboard: WASD and the arrow keys touch down at the joystick's default
+// center and push the stick to the clampzone edge in the held direction. Releasing all of them
+// lifts the virtual finger again.
+static int _keyboard_source(VirtualJoystick* joystick, const SDL_Event* event, VirtualJoystickTouchSample* samples) {
+    if ((event->type != SDL_KEYDOWN && event->type != SDL_KEYUP) || event->key.repeat) return 0;
+
+    Uint8 key;
+    switch (event->key.keysym.scancode) {
+        case SDL_SCANCODE_W: case SDL_SCANCODE_UP: key = 1 << 0; break;
+        case SDL_SCANCODE_A: case SDL_SCANCODE_LEFT: key = 1 << 1; break;
+        case SDL_SCANCODE_S: case SDL_SCANCODE_DOWN: key = 1 << 2; break;
+        case SDL_SCANCODE_D: case SDL_SCANCODE_RIGHT: key = 1 << 3; break;
+        default: return 0;
+    }
+    Uint8 previous_keys = joystick->_pressed_keys;
+    joystick->_pressed_keys = event->type == SDL_KEYDOWN ? (Uint8)(previous_keys | key) : (Uint8)(previous_keys & ~key);
+    if (joystick->_pressed_keys == previous_keys) return 0;
+
+    int count = 0;
+    if (!previous_keys) {
+        samples[count].phase = JOYSTICK_TOUCH_DOWN;
+        samples[count].x = joystick->_base_default_center.x;
+        samples[count].y = joystick->_base_default_center.y;
+        count++;
+    }
+    Uint8 keys = joystick->_pressed_keys;
+    if (keys) {
+        // Touching down moved a DYNAMIC base to the default center, so push from where the base is now.
+        Vector2 direction = Vector2_Normalize((Vector2){(float)(!!(keys & 8)) - (float)(!!(keys & 2)), (float)(!!(keys & 4)) - (float)(!!(keys & 1))});
+        SDL_FPoint origin = count ? joystick->_base_default_center : joystick->_base_center;
+        samples[count].phase = JOYSTICK_TOUCH_MOVE;
+        samples[count].x = origin.x + direction.x * joystick->clampzone_size;
+        samples[count].y = origin.y + direction.y * joystick->clampzone_size;
+        count++;
+    } else {
+        samples[count].phase = JOYSTICK_TOUCH_UP;
+        samples[count].x = joystick->_base_center.x;
+        samples[count].y = joystick->_base_center.y;
+        count++;
+    }
+    for (int i = 0; i < count; i++) {
+        samples[i].finger_id = VIRTUAL_JOYSTICK_KEYBOARD_FINGER;
+        samples[i].timestamp = event->key.timestamp;
+    }
+    return count;
+}
+
+// --- VirtualJoystickInputSourceEntry Structure ---
+// An input source and the flag that enables it on a joystick.
+typedef struct {
+    VirtualJoystickInputSource convert;
+    Uint32 flag;
+} VirtualJoystickInputSourceEntry;
+
+// Input sources by SDL event category (event type >> 8). SDL numbers related events together
+// (0x300 keyboard, 0x400 mouse, 0x700 touch, ...), so one lookup finds the source of any event.
+static VirtualJoystickInputSourceEntry _input_sources[256];
+static bool _input_sources_ready = false;
+
+// --- Helper Function: _get_input_source ---
+// Returns the input source of an event's category, filling in the built-in sources on first use.
+static inline const VirtualJoystickInputSourceEntry* _get_input_source(Uint32 event_type) {
+    if (!_input_sources_ready) {
+        _input_sources[SDL_FINGERDOWN >> 8] = (VirtualJoystickInputSourceEntry){_touch_source, JOYSTICK_INPUT_TOUCH};
+        _input_sources[SDL_MOUSEMOTION >> 8] = (VirtualJoystickInputSourceEntry){_mouse_source, JOYSTICK_INPUT_MOUSE};
+        _input_sources[SDL_KEYDOWN >> 8] = (VirtualJoystickInputSourceEntry){_keyboard_source, JOYSTICK_INPUT_KEYBOARD};
+        _input_sources_ready = true;
+    }
+    return &_input_sources[(event_type >> 8) & 0xFF];
+}
+
+// --- VirtualJoystick_SetInputSource ---
+// Registers a custom input source for all SDL events in the same category as event_type (event
+// types sharing event_type >> 8, e.g. SDL_USEREVENT and the types right after it). It replaces
+// any source for that category, including the built-in ones; joysticks use it if their
+// input_sources include JOYSTICK_INPUT_CUSTOM.
+// Parameters:
+//   event_type: An SDL event type of the category to handle.
+//   source: The converter, or NULL to ignore the category.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_SetInputSource(Uint32 event_type, VirtualJoystickInputSource source) {
+    _get_input_source(event_type); // Make sure the built-in sources do not overwrite this one later.
+    _input_sources[(event_type >> 8) & 0xFF] = (VirtualJoystickInputSourceEntry){source, JOYSTICK_INPUT_CUSTOM};
+}
+
+// --- VirtualJoystick_InjectSample ---
+// Feeds one touch sample directly into the joystick core, as if an input source produced it.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance.
+//   sample: The sample, in window pixels.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_InjectSample(VirtualJoystick* joystick, const VirtualJoystickTouchSample* sample) {
+    _process_sample(joystick, sample);
+    _finish_input(joystick);
+}
+
+// --- VirtualJoystick_InjectSamples ---
+// Feeds a batch of touch samples into the joystick core. Change records and the virtual device
+// are updated once for the whole batch, which makes this the cheapest way to replay or simulate
+// input: no SDL_Event has to be built and no coordinates normalized.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance.
+//   samples: The samples in the order they happened, in window pixels.
+//   count: Number of samples.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_InjectSamples(VirtualJoystick* joystick, const VirtualJoystickTouchSample* samples, int count) {
+    for (int i = 0; i < count; i++) {
+        _process_sample(joystick, &samples[i]);
+    }
+    _finish_input(joystick);
+}
+
+// --- VirtualJoystick_InjectOutputs ---
+// Sets the output of many joysticks directly, for bots that decide what the stick should output
+// rather than where a finger is. A non-zero output holds the joystick with
+// VIRTUAL_JOYSTICK_INJECTED_FINGER (unless a real finger already tracks it) and places the tip to
+// match; a zero output releases it again. Deadzone shaping is skipped: the given output is used
+// as is, limited to length 1.
+// Parameters:
+//   joysticks: The joysticks to drive.
+//   outputs: The output for the joystick at the same index.
+//   count: Number of joysticks.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_InjectOutputs(VirtualJoystick* const* joysticks, const Vector2* outputs, int count) {
+    for (int i = 0; i < count; i++) {
+        VirtualJoystick* joystick = joysticks[i];
+        Vector2 output = Vector2_LimitLength(outputs[i], 1.0f);
+        bool held = joystick->_touch_index == VIRTUAL_JOYSTICK_INJECTED_FINGER;
+
+        if (output.x == 0.0f && output.y == 0.0f) {
+            if (held) _reset_joystick(joystick);
+        } else if (held || joystick->_touch_index == -1) {
+            if (!held) {
+                joystick->_touch_index = VIRTUAL_JOYSTICK_INJECTED_FINGER;
+                joystick->_hidden = false;
+            }
+            joystick->output = output;
+            joystick->is_pressed = true;
+            _move_tip(joystick, (SDL_FPoint){joystick->_base_center.x + output.x * joystick->clampzone_size,
+                                             joystick->_base_center.y + output.y * joystick->clampzone_size});
+        }
+        _finish_input(joystick);
+    }
+}
+
+// --- VirtualJoystick_HandleEvent ---
+// Processes SDL events relevant to the joystick: renderer resets, and input from the sources
+// enabled in input_sources.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance.
+//   event: A pointer to the SDL_Event to process.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_HandleEvent(VirtualJoystick* joystick, const SDL_Event* event) {
+    // Renderer resets must be handled even while hidden, otherwise the next draw shows lost textures.
+    if (event->type == SDL_RENDER_TARGETS_RESET || event->type == SDL_RENDER_DEVICE_RESET) {
+        _invalidate_texture_sets(event->type == SDL_RENDER_DEVICE_RESET);
+        return;
+    }
+
+    const VirtualJoystickInputSourceEntry* source = _get_input_source(event->type);
+    if (!source->convert || !(joystick->input_sources & source->flag)) return;
+
+    VIRTUAL_JOYSTICK_TRACE_BEGIN("HandleEvent");
+    VirtualJoystickTouchSample samples[VIRTUAL_JOYSTICK_MAX_SOURCE_SAMPLES];
+    int count = source->convert(joystick, event, samples);
+    for (int i = 0; i < count; i++) {
+        _process_sample(joystick, &samples[i]);
+    }
+    if (count > 0) _finish_input(joystick);
+    VIRTUAL_JOYSTICK_TRACE_END("HandleEvent");
+}
+
+// --- Helper Function: _nearest_free_stick ---
+// Picks the stick a finger touching down at point should drive, in one pass over the sticks:
+// the free stick whose joystick_area is closest (distance 0 if it contains the point), with
+// ties broken by the distance to the stick's default center.
+// Returns: The stick's index, or -1 if every stick is busy.
+static inline int _nearest_free_stick(const VirtualJoystickGroup* group, SDL_FPoint point) {
+    int best = -1;
+    float best_area_distance = 0.0f, best_center_distance = 0.0f;
+    for (int i = 0; i < group->_stick_count; i++) {
+        const VirtualJoystick* stick = group->_sticks[i];
+        if (stick->_touch_index != -1) continue;
+        const SDL_Rect* area = &stick->joystick_area;
+        float dx = fmaxf(fmaxf((float)area->x - point.x, point.x - (float)(area->x + area->w)), 0.0f);
+        float dy = fmaxf(fmaxf((float)area->y - point.y, point.y - (float)(area->y + area->h)), 0.0f);
+        float area_distance = dx * dx + dy * dy;
+        float cx = point.x - stick->_base_default_center.x, cy = point.y - stick->_base_default_center.y;
+        float center_distance = cx * cx + cy * cy;
+        if (best == -1 || area_distance < best_area_distance ||
+            (area_distance == best_area_distance && center_distance < best_center_distance)) {
+            best = i;
+            best_area_distance = area_distance;
+            best_center_distance = center_distance;
+        }
+    }
+    return best;
+}
+
+// --- Helper Function: _find_group_finger ---
+// Returns: The index of a finger in the group's finger table, or -1 if it is not there.
+static inline int _find_group_finger(const VirtualJoystickGroup* group, SDL_FingerID finger_id) {
+    for (int i = 0; i < group->_finger_count; i++) {
+        if (group->_fingers[i].finger_id == finger_id) return i;
+    }
+    return -1;
+}
+
+// --- Helper Function: _update_gesture ---
+// Recomputes a gesture's results from its fingers' latest positions. Rotation is accumulated
+// from the angle change since the previous update, so it keeps counting past half a turn.
+static inline void _update_gesture(VirtualJoystickGesture* gesture) {
+    SDL_FPoint a = gesture->_positions[0], b = gesture->_positions[1];
+    gesture->centroid = (SDL_FPoint){(a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f};
+    gesture->pan = (Vector2){gesture->centroid.x - gesture->_start_centroid.x, gesture->centroid.y - gesture->_start_centroid.y};
+
+    Vector2 span = {b.x - a.x, b.y - a.y};
+    gesture->scale = Vector2_Length(span) / gesture->_start_distance;
+    float angle = atan2f(span.y, span.x);
+    float turn = angle - gesture->_last_angle;
+    if (turn > 3.14159265f) turn -= 2.0f * 3.14159265f;
+    else if (turn < -3.14159265f) turn += 2.0f * 3.14159265f;
+    gesture->rotation += turn;
+    gesture->_last_angle = angle;
+}
+
+// --- Helper Function: _start_gesture ---
+// Tries to start the group's gesture with a finger that just touched down (see
+// VirtualJoystickGesture for which fingers it pairs with).
+// Returns: true if the finger now drives the gesture.
+static inline bool _start_gesture(VirtualJoystickGroup* group, int index) {
+    VirtualJoystickGesture* gesture = group->_gesture;
+    VirtualJoystickGroupFinger* finger = &group->_fingers[index];
+    SDL_Point p = {(int)finger->position.x, (int)finger->position.y};
+    if (!gesture || gesture->active || !SDL_PointInRect(&p, &gesture->area)) return false;
+
+    int partner = -1;
+    for (int i = 0; i < group->_finger_count && partner == -1; i++) {
+        SDL_Point q = {(int)group->_fingers[i].position.x, (int)group->_fingers[i].position.y};
+        if (i != index && group->_fingers[i].stick == -1 && SDL_PointInRect(&q, &gesture->area)) partner = i;
+    }
+    for (int i = 0; i < group->_finger_count && partner == -1; i++) {
+        SDL_Point q = {(int)group->_fingers[i].position.x, (int)group->_fingers[i].position.y};
+        int stick = group->_fingers[i].stick;
+        if (i == index || stick < 0 || !SDL_PointInRect(&q, &gesture->area)) continue;
+        const VirtualJoystick* held = group->_sticks[stick];
+        if (_is_point_inside_joystick_area(held, finger->position) && (!held->is_pressed || gesture->steal_sticks)) {
+            _reset_joystick(group->_sticks[stick]);
+            _finish_input(group->_sticks[stick]);
+            partner = i;
+        }
+    }
+    if (partner == -1) return false;
+
+    VirtualJoystickGroupFinger* other = &group->_fingers[partner];
+    other->stick = VIRTUAL_JOYSTICK_GESTURE_STICK;
+    finger->stick = VIRTUAL_JOYSTICK_GESTURE_STICK;
+    gesture->_finger_ids[0] = other->finger_id;
+    gesture->_finger_ids[1] = finger->finger_id;
+    gesture->_positions[0] = other->position;
+    gesture->_positions[1] = finger->position;
+
+    Vector2 span = {finger->position.x - other->position.x, finger->position.y - other->position.y};
+    gesture->_start_centroid = (SDL_FPoint){(other->position.x + finger->position.x) * 0.5f, (other->position.y + finger->position.y) * 0.5f};
+    gesture->_start_distance = fmaxf(Vector2_Length(span), 1.0f); // Fingers at the same spot would divide by zero.
+    gesture->_last_angle = atan2f(span.y, span.x);
+    gesture->rotation = 0.0f;
+    gesture->active = true;
+    _update_gesture(gesture);
+    return true;
+}
+
+// --- Helper Function: _end_gesture ---
+// Stops the group's gesture. Its remaining fingers stay down but drive nothing.
+static inline void _end_gesture(VirtualJoystickGroup* group) {
+    if (!group->_gesture || !group->_gesture->active) return;
+    group->_gesture->active = false;
+    for (int i = 0; i < group->_finger_count; i++) {
+        if (group->_fingers[i].stick == VIRTUAL_JOYSTICK_GESTURE_STICK) group->_fingers[i].stick = -1;
+    }
+}
+
+// --- Helper Function: _process_group_sample ---
+// Routes one touch sample through a group: fingers touching down inside the area start the
+// gesture or are assigned to the nearest free stick, and motion and release are passed to
+// whatever the finger drives.
+static inline void _process_group_sample(VirtualJoystickGroup* group, const VirtualJoystickTouchSample* sample) {
+    SDL_FPoint point = {sample->x, sample->y};
+    int index = _find_group_finger(group, sample->finger_id);
+
+    if (sample->phase == JOYSTICK_TOUCH_DOWN) {
+        SDL_Point p = {(int)point.x, (int)point.y};
+        if (index != -1 || group->_finger_count == VIRTUAL_JOYSTICK_GROUP_FINGERS || !SDL_PointInRect(&p, &group->area)) return;
+        index = group->_finger_count++;
+        VirtualJoystickGroupFinger* finger = &group->_fingers[index];
+        finger->finger_id = sample->finger_id;
+        finger->position = point;
+        finger->stick = -1;
+        if (_start_gesture(group, index)) return;
+        finger->stick = _nearest_free_stick(group, point);
+        if (finger->stick != -1) {
+            VirtualJoystick* stick = group->_sticks[finger->stick];
+            _begin_touch(stick, sample);
+            _finish_input(stick);
+        }
+        return;
+    }
+
+    if (index == -1) return;
+    VirtualJoystickGroupFinger* finger = &group->_fingers[index];
+    finger->position = point;
+    if (finger->stick == VIRTUAL_JOYSTICK_GESTURE_STICK) {
+        VirtualJoystickGesture* gesture = group->_gesture;
+        if (sample->phase == JOYSTICK_TOUCH_UP) {
+            _end_gesture(group);
+        } else {
+            gesture->_positions[gesture->_finger_ids[0] == sample->finger_id ? 0 : 1] = point;
+            _update_gesture(gesture);
+        }
+    } else if (finger->stick != -1) {
+        VirtualJoystick* stick = group->_sticks[finger->stick];
+        _process_sample(stick, sample);
+        _finish_input(stick);
+    }
+    if (sample->phase == JOYSTICK_TOUCH_UP) {
+        group->_fingers[index] = group->_fingers[--group->_finger_count];
+    }
+}
+
+// --- VirtualJoystickGroup_Create ---
+// Creates a shared touch area for several sticks (see VirtualJoystickGroup).
+// Parameters:
+//   x, y, width, height: The shared area in window pixels.
+//   window_width, window_height: Current size of the window.
+// Returns: A pointer to the new VirtualJoystickGroup on success, NULL on failure.
+VIRTUAL_JOYSTICK_API VirtualJoystickGroup* VirtualJoystickGroup_Create(int x, int y, int width, int height, int window_width, int window_height) {
+    VirtualJoystickGroup* group = (VirtualJoystickGroup*)_joystick_calloc(1, sizeof(VirtualJoystickGroup));
+    if (!group) {
+        fprintf(stderr, "Failed to allocate VirtualJoystickGroup\n");
+        return NULL;
+    }
+    group->area = (SDL_Rect){x, y, width, height};
+    group->input_sources = JOYSTICK_INPUT_TOUCH | JOYSTICK_INPUT_CUSTOM;
+    group->_window_width = window_width;
+    group->_window_height = window_height;
+    return group;
+}
+
+// --- VirtualJoystickGroup_Destroy ---
+// Frees the group. The sticks in it are not destroyed.
+VIRTUAL_JOYSTICK_API void VirtualJoystickGroup_Destroy(VirtualJoystickGroup* group) {
+    _joystick_free(group);
+}
+
+// --- VirtualJoystickGroup_AddStick ---
+// Adds a stick to the group. Its joystick_area decides which fingers prefer it; it may lie
+// anywhere, since fingers are given to the nearest free stick.
+// Parameters:
+//   group: The group.
+//   joystick: The stick to add (not in another group).
+// Returns: true on success, false if the group already holds VIRTUAL_JOYSTICK_GROUP_STICKS sticks.
+VIRTUAL_JOYSTICK_API bool VirtualJoystickGroup_AddStick(VirtualJoystickGroup* group, VirtualJoystick* joystick) {
+    for (int i = 0; i < group->_stick_count; i++) {
+        if (group->_sticks[i] == joystick) return true;
+    }
+    if (group->_stick_count == VIRTUAL_JOYSTICK_GROUP_STICKS) {
+        fprintf(stderr, "A VirtualJoystickGroup holds at most %d sticks\n", VIRTUAL_JOYSTICK_GROUP_STICKS);
+        return false;
+    }
+    group->_sticks[group->_stick_count++] = joystick;
+    return true;
+}
+
+// --- VirtualJoystickGroup_RemoveStick ---
+// Removes a stick from the group, releasing it if a finger of the group was driving it.
+VIRTUAL_JOYSTICK_API void VirtualJoystickGroup_RemoveStick(VirtualJoystickGroup* group, VirtualJoystick* joystick) {
+    int removed = -1;
+    for (int i = 0; i < group->_stick_count; i++) {
+        if (group->_sticks[i] == joystick) removed = i;
+    }
+    if (removed == -1) return;
+
+    for (int i = 0; i < group->_finger_count; i++) {
+        VirtualJoystickGroupFinger* finger = &group->_fingers[i];
+        if (finger->stick == removed) {
+            _reset_joystick(joystick);
+            _finish_input(joystick);
+            finger->stick = -1;
+        } else if (finger->stick > removed) {
+            finger->stick--;
+        }
+    }
+    for (int i = removed + 1; i < group->_stick_count; i++) {
+        group->_sticks[i - 1] = group->_sticks[i];
+    }
+    group->_stick_count--;
+}
+
+// --- VirtualJoystickGroup_HandleEvent ---
+// Processes SDL events for the sticks and gesture of the group: renderer resets, and input from
+// the sources enabled in the group's input_sources. Touches are converted with the group's window
+// size; other sources are given the first stick (so they need one).
+// Parameters:
+//   group: The group.
+//   event: A pointer to the SDL_Event to process.
+VIRTUAL_JOYSTICK_API void VirtualJoystickGroup_HandleEvent(VirtualJoystickGroup* group, const SDL_Event* event) {
+    if (event->type == SDL_RENDER_TARGETS_RESET || event->type == SDL_RENDER_DEVICE_RESET) {
+        _invalidate_texture_sets(event->type == SDL_RENDER_DEVICE_RESET);
+        return;
+    }
+
+    // Keyboard samples are generated from one stick's state, so they cannot be shared.
+    const VirtualJoystickInputSourceEntry* source = _get_input_source(event->type);
+    if (!source->convert || !(group->input_sources & source->flag & ~(Uint32)JOYSTICK_INPUT_KEYBOARD)) return;
+    if (source->convert != _touch_source && group->_stick_count == 0) return;
+
+    VIRTUAL_JOYSTICK_TRACE_BEGIN("GroupHandleEvent");
+    VirtualJoystickTouchSample samples[VIRTUAL_JOYSTICK_MAX_SOURCE_SAMPLES];
+    int count = source->convert == _touch_source ? _convert_touch_event(event, group->_window_width, group->_window_height, samples)
+                                                 : source->convert(group->_sticks[0], event, samples);
+    for (int i = 0; i < count; i++) {
+        _process_group_sample(group, &samples[i]);
+    }
+    VIRTUAL_JOYSTICK_TRACE_END("GroupHandleEvent");
+}
+
+// --- VirtualJoystickGroup_InjectSample ---
+// Feeds one touch sample (in window pixels) through the group's finger assignment.
+VIRTUAL_JOYSTICK_API void VirtualJoystickGroup_InjectSample(VirtualJoystickGroup* group, const VirtualJoystickTouchSample* sample) {
+    _process_group_sample(group, sample);
+}
+
+// --- VirtualJoystickGroup_SetWindowSize ---
+// Updates the window size the group converts touch coordinates with (call it on resize, like
+// VirtualJoystick_SetWindowSize for the sticks).
+VIRTUAL_JOYSTICK_API void VirtualJoystickGroup_SetWindowSize(VirtualJoystickGroup* group, int window_width, int window_height) {
+    group->_window_width = window_width;
+    group->_window_height = window_height;
+}
+
+// --- VirtualJoystickGroup_SetGesture ---
+// Lets a gesture share the group's fingers with its sticks. A group has at most one gesture;
+// setting another one (or NULL) stops the previous one.
+// Parameters:
+//   group: The group.
+//   gesture: The gesture to recognize over the group's fingers, or NULL for none.
+VIRTUAL_JOYSTICK_API void VirtualJoystickGroup_SetGesture(VirtualJoystickGroup* group, VirtualJoystickGesture* gesture) {
+    _end_gesture(group);
+    group->_gesture = gesture;
+}
+
+// --- VirtualJoystickGesture_Create ---
+// Creates a two-finger gesture recognizer (see VirtualJoystickGesture). It receives input once
+// it is set on a group with VirtualJoystickGroup_SetGesture.
+// Parameters:
+//   x, y, width, height: The region the fingers must touch down in, in window pixels.
+// Returns: A pointer to the new VirtualJoystickGesture on success, NULL on failure.
+VIRTUAL_JOYSTICK_API VirtualJoystickGesture* VirtualJoystickGesture_Create(int x, int y, int width, int height) {
+    VirtualJoystickGesture* gesture = (VirtualJoystickGesture*)_joystick_calloc(1, sizeof(VirtualJoystickGesture));
+    if (!gesture) {
+        fprintf(stderr, "Failed to allocate VirtualJoystickGesture\n");
+        return NULL;
+    }
+    gesture->area = (SDL_Rect){x, y, width, height};
+    gesture->scale = 1.0f;
+    gesture->_start_distance = 1.0f;
+    return gesture;
+}
+
+// --- VirtualJoystickGesture_Destroy ---
+// Frees the gesture. Remove it from its group (VirtualJoystickGroup_SetGesture with NULL) first.
+VIRTUAL_JOYSTICK_API void VirtualJoystickGesture_Destroy(VirtualJoystickGesture* gesture) {
+    _joystick_free(gesture);
+}
+
+// --- VirtualJoystickAim_Create ---
+// Creates a gyro and stick aim fusion stage (see VirtualJoystickAim). Gyro input arrives through
+// VirtualJoystickAim_HandleEvent once a gyro is opened with VirtualJoystickAim_OpenGyro or the
+// game controller's gyro is enabled (SDL_GameControllerSetSensorEnabled), or through
+// VirtualJoystickAim_InjectGyro.
+// Parameters:
+//   stick: The stick to blend into the aim, or NULL for gyro only.
+// Returns: A pointer to the new VirtualJoystickAim on success, NULL on failure.
+VIRTUAL_JOYSTICK_API VirtualJoystickAim* VirtualJoystickAim_Create(VirtualJoystick* stick) {
+    VirtualJoystickAim* aim = (VirtualJoystickAim*)_joystick_calloc(1, sizeof(VirtualJoystickAim));
+    if (!aim) {
+        fprintf(stderr, "Failed to allocate VirtualJoystickAim\n");
+        return NULL;
+    }
+    aim->stick = stick;
+    aim->stick_speed = 1.0f;
+    aim->gyro_sensitivity = (Vector2){1.0f, 1.0f};
+    aim->yaw_axis = 1;   // SDL reports gyro rates in the device's natural (portrait) orientation:
+    aim->pitch_axis = 0; // turning around its y axis is yaw and around its x axis is pitch.
+    aim->bias_threshold = 0.05f;
+    aim->bias_settle_time = 0.5f;
+    aim->bias_time_constant = 2.0f;
+    aim->gyro_sensor = -1;
+    aim->use_controllers = true;
+    aim->controller_id = -1;
+    return aim;
+}
+
+// --- VirtualJoystickAim_Destroy ---
+// Frees the aim fusion stage and closes its gyro. The stick is not destroyed.
+VIRTUAL_JOYSTICK_API void VirtualJoystickAim_Destroy(VirtualJoystickAim* aim) {
+    if (!aim) return;
+    if (aim->_sensor) SDL_SensorClose(aim->_sensor);
+    _joystick_free(aim);
+}
+
+// --- VirtualJoystickAim_OpenGyro ---
+// Opens the device's first gyro and uses its SDL_SENSORUPDATE events instead of controller
+// gyros (use_controllers is turned off). SDL must be initialized with SDL_INIT_SENSOR.
+// Returns: true on success, false if there is no gyro or it could not be opened.
+VIRTUAL_JOYSTICK_API bool VirtualJoystickAim_OpenGyro(VirtualJoystickAim* aim) {
+    for (int i = 0; i < SDL_NumSensors(); i++) {
+        if (SDL_SensorGetDeviceType(i) != SDL_SENSOR_GYRO) continue;
+        SDL_Sensor* sensor = SDL_SensorOpen(i);
+        if (!sensor) {
+            fprintf(stderr, "Failed to open gyro sensor: %s\n", SDL_GetError());
+            return false;
+        }
+        if (aim->_sensor) SDL_SensorClose(aim->_sensor);
+        aim->_sensor = sensor;
+        aim->gyro_sensor = SDL_SensorGetInstanceID(sensor);
+        aim->use_controllers = false;
+        aim->_has_sample = false; // The previous source's timestamps do not apply.
+        return true;
+    }
+    fprintf(stderr, "No gyro sensor found\n");
+    return false;
+}
+
+// --- Helper Function: _inject_gyro ---
+// Feeds one gyro sample into the aim (see VirtualJoystickAim_InjectGyro). Gyros report at up to
+// a few kHz, so sample intervals are taken in microseconds; whole milliseconds would be off by
+// up to 1 ms per sample.
+// Parameters:
+//   aim: The aim fusion stage.
+//   rates: Rotation rates around the x, y and z axes in radians per second.
+//   timestamp_us: Time of the sample in microseconds.
+static inline void _inject_gyro(VirtualJoystickAim* aim, const float rates[3], Uint64 timestamp_us) {
+    // Samples further apart than this (e.g. after the app was paused) are not integrated fully.
+    // Timestamps that go backwards wrap to a huge interval and are clamped the same way.
+    float dt = aim->_has_sample ? fminf((float)(timestamp_us - aim->_last_timestamp) / 1000000.0f, 0.1f) : 0.0f;
+    aim->_last_timestamp = timestamp_us;
+    aim->_has_sample = true;
+
+    // Follow the bias while the gyro holds still: a still device should read zero.
+    if (aim->bias_time_constant > 0.0f) {
+        bool still = fabsf(rates[0] - aim->bias[0]) < aim->bias_threshold && fabsf(rates[1] - aim->bias[1]) < aim->bias_threshold &&
+                     fabsf(rates[2] - aim->bias[2]) < aim->bias_threshold;
+        aim->_still_time = still ? aim->_still_time + dt : 0.0f;
+        if (aim->_still_time >= aim->bias_settle_time) {
+            float k = fminf(dt / aim->bias_time_constant, 1.0f);
+            for (int i = 0; i < 3; i++) {
+                aim->bias[i] += (rates[i] - aim->bias[i]) * k;
+            }
+        }
+    }
+
+    // Turning left (counterclockwise around an upward axis) moves the aim left, tilting the top
+    // towards the player moves it up.
+    int yaw = (unsigned)aim->yaw_axis < 3 ? aim->yaw_axis : 1;
+    int pitch = (unsigned)aim->pitch_axis < 3 ? aim->pitch_axis : 0;
+    aim->_gyro_aim.x -= (rates[yaw] - aim->bias[yaw]) * dt * aim->gyro_sensitivity.x;
+    aim->_gyro_aim.y -= (rates[pitch] - aim->bias[pitch]) * dt * aim->gyro_sensitivity.y;
+}
+
+// --- VirtualJoystickAim_InjectGyro ---
+// Feeds one gyro sample into the aim, e.g. recorded or synthetic rates in tests.
+// Parameters:
+//   aim: The aim fusion stage.
+//   rates: Rotation rates around the x, y and z axes in radians per second.
+//   timestamp: Time of the sample in milliseconds (as in SDL event timestamps).
+VIRTUAL_JOYSTICK_API void VirtualJoystickAim_InjectGyro(VirtualJoystickAim* aim, const float rates[3], Uint32 timestamp) {
+    // Extend the 32-bit millisecond clock, which wraps after 49 days, by the time since the last sample.
+    Uint32 last_ms = (Uint32)(aim->_last_timestamp / 1000);
+    Uint64 timestamp_us = aim->_has_sample ? aim->_last_timestamp + (Uint64)(Uint32)(timestamp - last_ms) * 1000 : (Uint64)timestamp * 1000;
+    _inject_gyro(aim, rates, timestamp_us);
+}
+
+// --- VirtualJoystickAim_HandleEvent ---
+// Processes gyro events from one source, since all samples share the timing, bias and
+// stillness state: SDL_SENSORUPDATE of gyro_sensor or, while gyro_sensor is -1 and
+// use_controllers is set, SDL_CONTROLLERSENSORUPDATE of controller_id. With controller_id -1
+// the first controller sending gyro events is picked, and it is dropped again when it is
+// removed. Other events are ignored.
+// Parameters:
+//   aim: The aim fusion stage.
+//   event: A pointer to the SDL_Event to process.
+VIRTUAL_JOYSTICK_API void VirtualJoystickAim_HandleEvent(VirtualJoystickAim* aim, const SDL_Event* event) {
+    if (event->type == SDL_SENSORUPDATE) {
+        if (event->sensor.which == aim->gyro_sensor) {
+            _inject_gyro(aim, event->sensor.data, VIRTUAL_JOYSTICK_SENSOR_TIME_US(event->sensor));
+        }
+    }
+#if VIRTUAL_JOYSTICK_HAS_CONTROLLER_SENSORS
+    else if (event->type == SDL_CONTROLLERSENSORUPDATE) {
+        if (aim->use_controllers && aim->gyro_sensor == -1 && event->csensor.sensor == SDL_SENSOR_GYRO) {
+            if (aim->controller_id == -1) {
+                aim->controller_id = event->csensor.which;
+                aim->_has_sample = false;
+            }
+            if (event->csensor.which == aim->controller_id) {
+                _inject_gyro(aim, event->csensor.data, VIRTUAL_JOYSTICK_SENSOR_TIME_US(event->csensor));
+            }
+        }
+    } else if (event->type == SDL_CONTROLLERDEVICEREMOVED) {
+        if (event->cdevice.which == aim->controller_id) aim->controller_id = -1;
+    }
+#endif
+}
+
+// --- VirtualJoystickAim_Consume ---
+// Returns the aim movement for this frame and starts summing the next one: the gyro turning since
+// the last call plus the stick. A stick in JOYSTICK_MODE_RELATIVE adds its summed delta (see
+// VirtualJoystick_ConsumeRelativeDelta); other sticks add output * stick_speed * dt.
+// Parameters:
+//   aim: The aim fusion stage.
+//   dt: Length of the frame in seconds.
+// Returns: The aim movement (x right, y down).
+VIRTUAL_JOYSTICK_API Vector2 VirtualJoystickAim_Consume(VirtualJoystickAim* aim, float dt) {
+    Vector2 result = aim->_gyro_aim;
+    aim->_gyro_aim = (Vector2){0.0f, 0.0f};
+    VirtualJoystick* stick = aim->stick;
+    if (stick && stick->joystick_mode == JOYSTICK_MODE_RELATIVE) {
+        Vector2 delta = VirtualJoystick_ConsumeRelativeDelta(stick);
+        result.x += delta.x;
+        result.y += delta.y;
+    } else if (stick) {
+        result.x += stick->output.x * aim->stick_speed * dt;
+        result.y += stick->output.y * aim->stick_speed * dt;
+    }
+    return result;
+}
+
+// --- VirtualJoystick_PollChanges ---
+// Drains queued change records of joysticks with queue_changes set. A joystick has at most one
+// queued record: later changes update it and combine its flags, so the queue never holds more
+// records than there are joysticks, and consumers only visit the joysticks that changed.
+// Parameters:
+//   changes: Array receiving the records.
+//   max_changes: Length of the array. Records that do not fit stay queued for the next call.
+// Returns: The number of records written.
+VIRTUAL_JOYSTICK_API int VirtualJoystick_PollChanges(VirtualJoystickChange* changes, int max_changes) {
+    int count = _change_count < max_changes ? _change_count : max_changes;
+    for (int i = 0; i < count; i++) {
+        changes[i] = _change_queue[i];
+        changes[i].joystick->_queued_change = -1;
+    }
+    // Move the records that did not fit to the front.
+    for (int i = count; i < _change_count; i++) {
+        _change_queue[i - count] = _change_queue[i];
+        _change_queue[i - count].joystick->_queued_change = i - count;
+    }
+    _change_count -= count;
+    return count;
+}
+
+// --- VirtualJoystick_AttachDevice ---
+// Exposes the joystick as an SDL virtual game controller, so code reading SDL_GameController
+// (or SDL_Joystick) axes gets touch input without copying output every frame. output drives a
+// stick and is_pressed the matching stick button; HandleEvent pushes them only when they change.
+// The joystick subsystem must be initialized (SDL_INIT_JOYSTICK or SDL_INIT_GAMECONTROLLER).
+// Needs SDL 2.24 or newer.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance.
+//   x_axis: SDL_CONTROLLER_AXIS_LEFTX for the left stick or SDL_CONTROLLER_AXIS_RIGHTX for the right stick.
+// Returns: true on success, false on failure.
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_AttachDevice(VirtualJoystick* joystick, SDL_GameControllerAxis x_axis) {
+#if VIRTUAL_JOYSTICK_HAS_VIRTUAL_DEVICE
+    if (x_axis != SDL_CONTROLLER_AXIS_LEFTX && x_axis != SDL_CONTROLLER_AXIS_RIGHTX) {
+        fprintf(stderr, "Virtual joystick devices need a LEFTX or RIGHTX axis\n");
+        return false;
+    }
+    VirtualJoystick_DetachDevice(joystick);
+
+    // A game controller type with the standard axis and button count gets SDL's automatic mapping.
+    int device_index = SDL_JoystickAttachVirtual(SDL_JOYSTICK_TYPE_GAMECONTROLLER, SDL_CONTROLLER_AXIS_MAX, SDL_CONTROLLER_BUTTON_MAX, 0);
+    if (device_index < 0) {
+        fprintf(stderr, "Failed to attach virtual joystick device: %s\n", SDL_GetError());
+        return false;
+    }
+    joystick->_device = SDL_JoystickOpen(device_index);
+    if (!joystick->_device) {
+        fprintf(stderr, "Failed to open virtual joystick device: %s\n", SDL_GetError());
+        SDL_JoystickDetachVirtual(device_index);
+        return false;
+    }
+
+    // Virtual axes start at 0, which the controller mapping reads as half-pressed triggers.
+    SDL_JoystickSetVirtualAxis(joystick->_device, SDL_CONTROLLER_AXIS_TRIGGERLEFT, SDL_JOYSTICK_AXIS_MIN);
+    SDL_JoystickSetVirtualAxis(joystick->_device, SDL_CONTROLLER_AXIS_TRIGGERRIGHT, SDL_JOYSTICK_AXIS_MIN);
+
+    joystick->_device_axis = x_axis;
+    joystick->_device_axes[0] = joystick->_device_axes[1] = 0;
+    joystick->_device_button = false;
+    _sync_device(joystick);
+    return true;
+#else
+    (void)joystick; (void)x_axis;
+    fprintf(stderr, "Virtual joystick devices need SDL 2.24 or newer\n");
+    return false;
+#endif
+}
+
+// --- VirtualJoystick_DetachDevice ---
+// Removes the SDL virtual joystick device attached with VirtualJoystick_AttachDevice, if any.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_DetachDevice(VirtualJoystick* joystick) {
+#if VIRTUAL_JOYSTICK_HAS_VIRTUAL_DEVICE
+    if (!joystick->_device) return;
 
-// --- Implementation Block ---
-// This block contains the actual definitions of the functions.
-// It is guarded by VIRTUAL_JOYSTICK_IMPLEMENTATION.
-// If you include this header in a .c/.cpp file and want to compile the main
-// application, you can define VIRTUAL_JOYSTICK_IMPLEMENTATION *before* including
-// this header. If you just compile this .h file directly, it will define it itself.
-#if !defined(VIRTUAL_JOYSTICK_IMPLEMENTATION) && !defined(VIRTUAL_JOYSTICK_NO_MAIN)
-    #define VIRTUAL_JOYSTICK_IMPLEMENTATION // Automatically define if not explicitly prevented
+    // Device indices shift as devices come and go, so look ours up by its instance ID.
+    SDL_JoystickID instance_id = SDL_JoystickInstanceID(joystick->_device);
+    SDL_JoystickClose(joystick->_device);
+    joystick->_device = NULL;
+    for (int i = 0; i < SDL_NumJoysticks(); i++) {
+        if (SDL_JoystickGetDeviceInstanceID(i) == instance_id) {
+            SDL_JoystickDetachVirtual(i);
+            break;
+        }
+    }
+#else
+    (void)joystick;
 #endif
+}
 
-#ifdef VIRTUAL_JOYSTICK_IMPLEMENTATION
-
-// --- Helper Function: create_circle_texture ---
-// Creates an SDL_Texture containing a filled circle. This is used to draw the joystick's base and tip.
+// --- VirtualJoystick_PublishShared ---
+// Publishes the joystick's state to a POSIX shared memory object, so other processes (recorders,
+// analysis tools) can follow it without going through stdout. After every processed input the
+// latest snapshot and a ring of recent ones are updated; see VirtualJoystickSharedRegion for the
+// layout and VirtualJoystickShared_ReadCurrent/ReadRecent for reading it.
+// virtual_joystick_shm_reader.c is a small reader for trying it out.
+// Each name has a single writer: publishing fails if the object already exists, so a second
+// publisher cannot take over a live one. An object left behind by a publisher that crashed must
+// be removed first (shm_unlink, or deleting it from /dev/shm on Linux).
 // Parameters:
-//   renderer: The SDL_Renderer to create the texture with.
-//   radius: The radius of the circle to draw.
-//   color: The SDL_Color of the circle.
-// Returns: An SDL_Texture* on success, NULL on failure.
-static inline SDL_Texture* create_circle_texture(SDL_Renderer* renderer, int radius, SDL_Color color) {
-    int diameter = radius * 2;
-    // Create a texture with RGBA format and render target access.
-    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, diameter, diameter);
-    if (!texture) {
-        fprintf(stderr, "Failed to create circle texture: %s\n", SDL_GetError());
-        return NULL;
+//   joystick: A pointer to the VirtualJoystick instance.
+//   name: Name of the shared memory object, starting with a slash (e.g. "/virtual_joystick").
+// Returns: true on success, false on failure (or on platforms without POSIX shared memory).
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_PublishShared(VirtualJoystick* joystick, const char* name) {
+#if VIRTUAL_JOYSTICK_HAS_SHARED_MEMORY
+    VirtualJoystick_UnpublishShared(joystick);
+
+    size_t name_length = SDL_strlen(name);
+    char* name_copy = (char*)_joystick_malloc(name_length + 1);
+    if (!name_copy) {
+        fprintf(stderr, "Failed to allocate shared memory name\n");
+        return false;
     }
+    SDL_memcpy(name_copy, name, name_length + 1);
 
-    // Enable blending for transparency.
-    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
-    // Set the texture as the current rendering target.
-    SDL_SetRenderTarget(renderer, texture);
-
-    // Clear the texture with transparent color before drawing.
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0); // Transparent black
-    SDL_RenderClear(renderer);
-
-    // Draw filled circle by iterating pixels within the radius.
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    for (int y = -radius; y <= radius; y++) {
-        for (int x = -radius; x <= radius; x++) {
-            if (x * x + y * y <= radius * radius) {
-                SDL_RenderDrawPoint(renderer, radius + x, radius + y);
-            }
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        if (errno == EEXIST) {
+            fprintf(stderr, "Shared memory %s is already published (remove it if its publisher crashed)\n", name);
+        } else {
+            fprintf(stderr, "Failed to open shared memory %s\n", name);
         }
+        _joystick_free(name_copy);
+        return false;
+    }
+    void* data = MAP_FAILED;
+    if (ftruncate(fd, (off_t)sizeof(VirtualJoystickSharedRegion)) == 0) {
+        data = mmap(NULL, sizeof(VirtualJoystickSharedRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd); // The mapping stays valid without the descriptor.
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Failed to map shared memory %s\n", name);
+        shm_unlink(name);
+        _joystick_free(name_copy);
+        return false;
     }
 
-    // Reset render target to the default window renderer.
-    SDL_SetRenderTarget(renderer, NULL);
-    return texture;
-}
+    // Readers check magic and version before anything else, so write them last.
+    VirtualJoystickSharedRegion* region = (VirtualJoystickSharedRegion*)data;
+    SDL_memset(region, 0, sizeof(*region));
+    region->ring_length = VIRTUAL_JOYSTICK_SHARED_RING;
+    region->version = VIRTUAL_JOYSTICK_SHARED_VERSION;
+    SDL_MemoryBarrierRelease();
+    region->magic = VIRTUAL_JOYSTICK_SHARED_MAGIC;
 
-// --- Helper Function: _is_point_inside_joystick_area ---
-// Checks if a given point is within the overall interaction area of the joystick.
-static inline bool _is_point_inside_joystick_area(const VirtualJoystick* joystick, SDL_FPoint point) {
-    SDL_Point p = {(int)point.x, (int)point.y};
-    return SDL_PointInRect(&p, &joystick->joystick_area);
+    joystick->_shared = region;
+    joystick->_shared_name = name_copy;
+    _publish_shared(joystick);
+    return true;
+#else
+    (void)joystick; (void)name;
+    fprintf(stderr, "Shared memory publishing is not available on this platform\n");
+    return false;
+#endif
 }
 
-// --- Helper Function: _is_point_inside_base ---
-// Checks if a given point is within the circular base of the joystick.
-static inline bool _is_point_inside_base(const VirtualJoystick* joystick, SDL_FPoint point) {
-    float dx = point.x - joystick->_base_center.x;
-    float dy = point.y - joystick->_base_center.y;
-    return (dx * dx + dy * dy) <= (joystick->_base_radius * joystick->_base_radius);
+// --- VirtualJoystick_UnpublishShared ---
+// Stops publishing and removes the shared memory object created by VirtualJoystick_PublishShared.
+// Readers that still have it mapped keep their (now frozen) view.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_UnpublishShared(VirtualJoystick* joystick) {
+#if VIRTUAL_JOYSTICK_HAS_SHARED_MEMORY
+    if (!joystick->_shared) return;
+    munmap(joystick->_shared, sizeof(VirtualJoystickSharedRegion));
+    shm_unlink(joystick->_shared_name);
+    _joystick_free(joystick->_shared_name);
+    joystick->_shared = NULL;
+    joystick->_shared_name = NULL;
+#else
+    (void)joystick;
+#endif
 }
 
-// --- Helper Function: _move_base ---
-// Updates the center position of the joystick's base.
-static inline void _move_base(VirtualJoystick* joystick, SDL_FPoint new_center) {
-    joystick->_base_center = new_center;
+// --- VirtualJoystick_ConsumeRelativeDelta ---
+// Returns the finger motion summed up in RELATIVE mode since the last call and resets it, so a
+// game reads one delta per frame no matter how many motion events arrived. Motion made before
+// the finger was lifted is still returned by the next call.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance.
+// Returns: The summed, sensitivity-scaled motion in pixels (zero if nothing moved).
+VIRTUAL_JOYSTICK_API Vector2 VirtualJoystick_ConsumeRelativeDelta(VirtualJoystick* joystick) {
+    Vector2 delta = joystick->_relative_delta;
+    joystick->_relative_delta = (Vector2){0.0f, 0.0f};
+    return delta;
 }
 
-// --- Helper Function: _move_tip ---
-// Updates the center position of the joystick's tip.
-static inline void _move_tip(VirtualJoystick* joystick, SDL_FPoint new_center) {
-    joystick->_tip_center = new_center;
+// --- VirtualJoystick_Update ---
+// Advances the joystick's spring animations (see return_spring_frequency and
+// follow_spring_frequency). Call it once per frame; joysticks without a running animation return
+// immediately.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance.
+//   dt: Time since the previous update in seconds.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_Update(VirtualJoystick* joystick, float dt) {
+    if (!joystick->_base_following && !joystick->_returning) return;
+
+    if (joystick->_base_following &&
+        _step_spring(&joystick->_base_draw_center, &joystick->_base_velocity, joystick->_base_center, joystick->follow_spring_frequency, dt)) {
+        joystick->_base_following = false;
+    }
+    if (joystick->_returning &&
+        _step_spring(&joystick->_tip_draw_center, &joystick->_tip_velocity, joystick->_tip_center, joystick->return_spring_frequency, dt)) {
+        // Back at the base: finish the reset the release started.
+        _park_joystick(joystick);
+    }
 }
 
-// --- Helper Function: _update_joystick_logic ---
-// Contains the core logic for calculating joystick output and updating tip position
-// based on the current touch position.
-static inline void _update_joystick_logic(VirtualJoystick* joystick, SDL_FPoint touch_position) {
-    // Calculate vector from base center to touch position.
-    Vector2 vector_from_base_center = (Vector2){touch_position.x - joystick->_base_center.x,
-                                                touch_position.y - joystick->_base_center.y};
+// --- VirtualJoystick_IsActive ---
+// Checks if a finger is currently tracking the joystick.
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_IsActive(const VirtualJoystick* joystick) {
+    return joystick->_touch_index != -1;
+}
 
-    // Limit the vector length to the clampzone_size.
-    Vector2 clamped_vector = Vector2_LimitLength(vector_from_base_center, joystick->clampzone_size);
+// --- VirtualJoystick_IsAnimating ---
+// Checks if a spring animation is running, i.e. VirtualJoystick_Update changes what is drawn.
+VIRTUAL_JOYSTICK_API bool VirtualJoystick_IsAnimating(const VirtualJoystick* joystick) {
+    return joystick->_base_following || joystick->_returning;
+}
 
-    // Handle FOLLOWING joystick mode: move the base if finger moves outside clampzone.
-    if (joystick->joystick_mode == JOYSTICK_MODE_FOLLOWING && Vector2_Length(vector_from_base_center) > joystick->clampzone_size) {
-        // Calculate new base center to keep the tip at the clampzone edge.
-        SDL_FPoint new_base_center = (SDL_FPoint){touch_position.x - clamped_vector.x,
-                                                  touch_position.y - clamped_vector.y};
-        _move_base(joystick, new_base_center);
+// --- VirtualJoystick_GetUpdateTimeout ---
+// Tells a host how long it may sleep, for example with SDL_WaitEventTimeout, before the given
+// controls need another VirtualJoystick_Update and draw. Controls only change on input events or
+// while they animate, so hosts that redraw on demand do not spin while everything is idle. While
+// a spring animates, the timeout is the time it takes to move about one pixel, which caps the
+// frame rate of slow animations instead of redrawing as fast as possible.
+// Parameters:
+//   joysticks: The controls to check.
+//   count: Number of controls.
+// Returns: Milliseconds until the earliest control needs an update (a few ms while animating),
+//          or -1 if nothing changes until the next input event. SDL_WaitEventTimeout treats -1
+//          as waiting without a timeout.
+VIRTUAL_JOYSTICK_API int VirtualJoystick_GetUpdateTimeout(VirtualJoystick* const* joysticks, int count) {
+    int timeout = -1;
+    for (int i = 0; i < count; i++) {
+        const VirtualJoystick* joystick = joysticks[i];
+        int step_ms = -1;
+        if (joystick->_base_following) {
+            step_ms = _spring_step_ms(joystick->_base_draw_center, joystick->_base_velocity, joystick->_base_center, joystick->follow_spring_frequency);
+        }
+        if (joystick->_returning) {
+            int tip_step_ms = _spring_step_ms(joystick->_tip_draw_center, joystick->_tip_velocity, joystick->_tip_center, joystick->return_spring_frequency);
+            if (step_ms < 0 || tip_step_ms < step_ms) step_ms = tip_step_ms;
+        }
+        if (step_ms >= 0 && (timeout < 0 || step_ms < timeout)) timeout = step_ms;
     }
+    return timeout;
+}
 
-    // Update tip position relative to the current base center.
-    _move_tip(joystick, (SDL_FPoint){joystick->_base_center.x + clamped_vector.x,
-                                     joystick->_base_center.y + clamped_vector.y});
+// --- Helper Function: _draw_joystick ---
+// Draws a visible joystick's base and tip, without the debug overlay.
+static inline void _draw_joystick(const VirtualJoystick* joystick, SDL_Renderer* renderer) {
+    VIRTUAL_JOYSTICK_TRACE_BEGIN("Draw");
+    VirtualJoystickTextureSet* set = _get_texture_set(renderer, false);
+    if (set) {
+        // Calculate destination rectangles for the base and tip.
+        SDL_Rect base_dst_rect, tip_dst_rect;
+        _get_draw_rects(joystick, &base_dst_rect, &tip_dst_rect);
 
-    // Calculate joystick output based on deadzone and clampzone.
-    if (Vector2_Length(clamped_vector) > joystick->deadzone_size) {
-        joystick->is_pressed = true;
-        Vector2 normalized_vector = Vector2_Normalize(clamped_vector);
-        float effective_length = Vector2_Length(clamped_vector) - joystick->deadzone_size;
-        float max_effective_length = joystick->clampzone_size - joystick->deadzone_size;
+        const VirtualJoystickBitmap* base_bitmap;
+        const VirtualJoystickBitmap* tip_bitmap;
+        const SDL_Rect* base_src_rect;
+        const SDL_Rect* tip_src_rect;
+        SDL_Color tip_color;
+        _get_draw_sources(joystick, &base_bitmap, &base_src_rect, &tip_bitmap, &tip_src_rect, &tip_color);
 
-        if (max_effective_length <= 0.0f) { // Prevent division by zero if clampzone <= deadzone.
-            joystick->output = (Vector2){0.0f, 0.0f};
-        } else {
-            // Normalize output to range -1 to 1.
-            joystick->output = (Vector2){normalized_vector.x * (effective_length / max_effective_length),
-                                         normalized_vector.y * (effective_length / max_effective_length)};
-        }
-    } else {
-        joystick->is_pressed = false;
-        joystick->output = (Vector2){0.0f, 0.0f};
+        // Render the base.
+        _draw_bitmap(set, base_bitmap, base_src_rect, &base_dst_rect, (SDL_Color){255, 255, 255, 255});
+
+        // Render the tip, tinted with pressed_color while a finger is tracking the joystick.
+        _draw_bitmap(set, tip_bitmap, tip_src_rect, &tip_dst_rect, tip_color);
     }
+    VIRTUAL_JOYSTICK_TRACE_END("Draw");
 }
 
-// --- Helper Function: _reset_joystick ---
-// Resets the joystick to its default, unpressed state.
-static inline void _reset_joystick(VirtualJoystick* joystick) {
-    joystick->is_pressed = false;
-    joystick->output = (Vector2){0.0f, 0.0f};
-    joystick->_touch_index = -1; // No finger is currently touching.
+// --- VirtualJoystick_Draw ---
+// Renders the joystick onto the screen, with the debug overlay on top if debug_overlay is set.
+// Parameters:
+//   joystick: A pointer to the VirtualJoystick instance.
+//   renderer: The SDL_Renderer to draw with. It does not have to be the one the joystick was
+//             created with; textures for a new renderer are created on the first draw.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_Draw(VirtualJoystick* joystick, SDL_Renderer* renderer) {
+    if (!joystick->_hidden) _draw_joystick(joystick, renderer); // Hidden sticks only show their overlay.
+    if (joystick->debug_overlay) VirtualJoystick_DrawDebugOverlay(joystick, renderer);
+}
 
-    // Reset tip color to default.
-    SDL_SetTextureColorMod(joystick->_tip_texture, joystick->_default_tip_color.r, joystick->_default_tip_color.g, joystick->_default_tip_color.b);
+// --- VirtualJoystickDebugGeometry Structure ---
+// Vertices and indices of a control's debug overlay, collected so it can be drawn with one call.
+#define VIRTUAL_JOYSTICK_DEBUG_VERTICES ((VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS * 3 + VIRTUAL_JOYSTICK_TOUCH_HISTORY + 13) * 4) // Three rings, the path, the output vector, the area and the snap lines.
+typedef struct {
+    SDL_Vertex vertices[VIRTUAL_JOYSTICK_DEBUG_VERTICES];
+    int indices[VIRTUAL_JOYSTICK_DEBUG_VERTICES / 4 * 6];
+    int vertex_count;
+    int index_count;
+} VirtualJoystickDebugGeometry;
 
-    // Reset base and tip positions to their defaults.
-    _move_base(joystick, joystick->_base_default_center);
-    _move_tip(joystick, joystick->_base_default_center); // Tip goes back to base center.
+// --- Helper Function: _push_debug_quad ---
+// Adds a quad (two triangles) with one color to the debug geometry.
+static inline void _push_debug_quad(VirtualJoystickDebugGeometry* geometry, SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_FPoint d, SDL_Color color) {
+    int base = geometry->vertex_count;
+    SDL_FPoint corners[4] = {a, b, c, d};
+    for (int i = 0; i < 4; i++) {
+        geometry->vertices[base + i].position = corners[i];
+        geometry->vertices[base + i].color = color;
+        geometry->vertices[base + i].tex_coord = (SDL_FPoint){0.0f, 0.0f};
+    }
+    static const int quad_indices[6] = {0, 1, 2, 2, 1, 3};
+    for (int i = 0; i < 6; i++) {
+        geometry->indices[geometry->index_count++] = base + quad_indices[i];
+    }
+    geometry->vertex_count += 4;
+}
 
-    joystick->_hidden = true; // Hide the joystick after release.
+// --- Helper Function: _push_debug_line ---
+// Adds a line segment of VIRTUAL_JOYSTICK_DEBUG_LINE_WIDTH pixels as a quad.
+static inline void _push_debug_line(VirtualJoystickDebugGeometry* geometry, SDL_FPoint from, SDL_FPoint to, SDL_Color color) {
+    float dx = to.x - from.x;
+    float dy = to.y - from.y;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length == 0.0f) return;
+    float nx = -dy / length * (VIRTUAL_JOYSTICK_DEBUG_LINE_WIDTH * 0.5f);
+    float ny = dx / length * (VIRTUAL_JOYSTICK_DEBUG_LINE_WIDTH * 0.5f);
+    _push_debug_quad(geometry, (SDL_FPoint){from.x + nx, from.y + ny}, (SDL_FPoint){from.x - nx, from.y - ny},
+                     (SDL_FPoint){to.x + nx, to.y + ny}, (SDL_FPoint){to.x - nx, to.y - ny}, color);
 }
 
+// --- Helper Function: _push_debug_ring ---
+// Adds a circle outline of VIRTUAL_JOYSTICK_DEBUG_LINE_WIDTH pixels, one quad per segment.
+static inline void _push_debug_ring(VirtualJoystickDebugGeometry* geometry, SDL_FPoint center, float radius, SDL_Color color) {
+    if (radius <= 0.0f) return;
+    float inner = radius - VIRTUAL_JOYSTICK_DEBUG_LINE_WIDTH * 0.5f;
+    float outer = radius + VIRTUAL_JOYSTICK_DEBUG_LINE_WIDTH * 0.5f;
+    if (inner < 0.0f) inner = 0.0f;
+    for (int i = 0; i < VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS; i++) {
+        float a0 = 2.0f * 3.14159265f * i / VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS;
+        float a1 = 2.0f * 3.14159265f * (i + 1) / VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS;
+        _push_debug_quad(geometry,
+                         (SDL_FPoint){center.x + cosf(a0) * inner, center.y + sinf(a0) * inner},
+                         (SDL_FPoint){center.x + cosf(a0) * outer, center.y + sinf(a0) * outer},
+                         (SDL_FPoint){center.x + cosf(a1) * inner, center.y + sinf(a1) * inner},
+                         (SDL_FPoint){center.x + cosf(a1) * outer, center.y + sinf(a1) * outer}, color);
+    }
+}
 
-// --- VirtualJoystick_Create ---
-// Initializes and allocates a new VirtualJoystick instance.
+// --- VirtualJoystick_DrawDebugOverlay ---
+// Draws tuning aids for a joystick: the outline of its joystick_area (white), the deadzone ring
+// (red), the clampzone ring (yellow), the ring where the outer deadzone starts (orange), the
+// limits of axis snapping (magenta), the raw path of the current touch (cyan, older positions
+// fade out) and the output vector scaled to the clampzone (green). VirtualJoystick_Draw and
+// VirtualJoystickHUD_Draw draw it on top of the control when debug_overlay is set; call it
+// directly to show the overlay for controls drawn through a draw list.
+// Everything is submitted with a single SDL_RenderGeometry call. Without SDL_RenderGeometry
+// (SDL older than 2.0.18) the same shapes are drawn as hairlines, one SDL_RenderDrawLinesF
+// call per color.
 // Parameters:
-//   renderer: The SDL_Renderer to be used for drawing the joystick.
-//   x, y: The top-left coordinates of the joystick's overall interaction area.
-//   width, height: The dimensions of the joystick's overall interaction area.
-//   window_width, window_height: The current dimensions of the window.
-// Returns: A pointer to the newly created VirtualJoystick on success, NULL on failure.
-VirtualJoystick* VirtualJoystick_Create(SDL_Renderer* renderer, int x, int y, int width, int height, int window_width, int window_height) {
-    VirtualJoystick* joystick = (VirtualJoystick*)malloc(sizeof(VirtualJoystick));
-    if (!joystick) {
-        fprintf(stderr, "Failed to allocate VirtualJoystick\n");
-        return NULL;
+//   joystick: A pointer to the VirtualJoystick instance.
+//   renderer: The SDL_Renderer to draw with.
+VIRTUAL_JOYSTICK_API void VirtualJoystick_DrawDebugOverlay(const VirtualJoystick* joystick, SDL_Renderer* renderer) {
+    SDL_FPoint center = joystick->_base_center;
+    SDL_FPoint output_end = {center.x + joystick->output.x * joystick->clampzone_size,
+                             center.y + joystick->output.y * joystick->clampzone_size};
+    const SDL_Rect* area = &joystick->joystick_area;
+    SDL_FPoint area_corners[5] = {{(float)area->x, (float)area->y}, {(float)(area->x + area->w), (float)area->y},
+                                  {(float)(area->x + area->w), (float)(area->y + area->h)}, {(float)area->x, (float)(area->y + area->h)},
+                                  {(float)area->x, (float)area->y}};
+    float outer_radius = joystick->outer_deadzone_size > 0.0f ? joystick->clampzone_size - joystick->outer_deadzone_size : 0.0f;
+    // Snapping limits: two rays per axis, snap_angle to either side of it.
+    int snap_count = joystick->snap_angle > 0.0f ? 8 : 0;
+    SDL_FPoint snap_ends[8];
+    for (int i = 0; i < snap_count; i++) {
+        float angle = (i / 2) * (3.14159265f * 0.5f) + ((i & 1) ? 1.0f : -1.0f) * joystick->snap_angle * (3.14159265f / 180.0f);
+        snap_ends[i] = (SDL_FPoint){center.x + cosf(angle) * joystick->clampzone_size, center.y + sinf(angle) * joystick->clampzone_size};
     }
+    SDL_Color area_color = {255, 255, 255, 160};
+    SDL_Color deadzone_color = {255, 64, 64, 220};
+    SDL_Color clampzone_color = {255, 220, 64, 220};
+    SDL_Color outer_color = {255, 140, 32, 220};
+    SDL_Color snap_color = {255, 64, 255, 160};
+    SDL_Color path_color = {64, 220, 255, 255};
+    SDL_Color output_color = {64, 255, 64, 255};
 
-    joystick->renderer = renderer;
-    joystick->joystick_area = (SDL_Rect){x, y, width, height};
-    joystick->_window_width = window_width;
-    joystick->_window_height = window_height;
+#if VIRTUAL_JOYSTICK_HAS_GEOMETRY
+    VirtualJoystickDebugGeometry geometry;
+    geometry.vertex_count = 0;
+    geometry.index_count = 0;
+    for (int i = 0; i < 4; i++) {
+        _push_debug_line(&geometry, area_corners[i], area_corners[i + 1], area_color);
+    }
+    for (int i = 0; i < snap_count; i++) {
+        _push_debug_line(&geometry, center, snap_ends[i], snap_color);
+    }
+    _push_debug_ring(&geometry, center, joystick->deadzone_size, deadzone_color);
+    _push_debug_ring(&geometry, center, joystick->clampzone_size, clampzone_color);
+    _push_debug_ring(&geometry, center, outer_radius, outer_color);
+    for (int i = 1; i < joystick->_touch_history_count; i++) {
+        SDL_FPoint from = joystick->_touch_history[(joystick->_touch_history_start + i - 1) % VIRTUAL_JOYSTICK_TOUCH_HISTORY];
+        SDL_FPoint to = joystick->_touch_history[(joystick->_touch_history_start + i) % VIRTUAL_JOYSTICK_TOUCH_HISTORY];
+        path_color.a = (Uint8)(255 * i / joystick->_touch_history_count);
+        _push_debug_line(&geometry, from, to, path_color);
+    }
+    _push_debug_line(&geometry, center, output_end, output_color);
+    if (geometry.index_count == 0) return;
 
-    // Set default properties.
-    joystick->pressed_color = (SDL_Color){100, 100, 100, 180}; // Medium gray, semi-transparent
-    joystick->deadzone_size = 10.0f;
-    joystick->clampzone_size = 75.0f;
-    joystick->joystick_mode = JOYSTICK_MODE_DYNAMIC; // Dynamic mode by default
+    SDL_BlendMode previous_blend_mode;
+    SDL_GetRenderDrawBlendMode(renderer, &previous_blend_mode);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_RenderGeometry(renderer, NULL, geometry.vertices, geometry.vertex_count, geometry.indices, geometry.index_count);
+    SDL_SetRenderDrawBlendMode(renderer, previous_blend_mode);
+#else
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+    SDL_FPoint points[VIRTUAL_JOYSTICK_TOUCH_HISTORY > VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS ? VIRTUAL_JOYSTICK_TOUCH_HISTORY : VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS + 1];
+    SDL_SetRenderDrawColor(renderer, area_color.r, area_color.g, area_color.b, area_color.a);
+    SDL_RenderDrawLinesF(renderer, area_corners, 5);
+    if (snap_count > 0) {
+        // Going back to the center between rays draws every ray in one polyline.
+        for (int i = 0; i < snap_count; i++) {
+            points[i * 2] = center;
+            points[i * 2 + 1] = snap_ends[i];
+        }
+        SDL_SetRenderDrawColor(renderer, snap_color.r, snap_color.g, snap_color.b, snap_color.a);
+        SDL_RenderDrawLinesF(renderer, points, snap_count * 2);
+    }
+    float radii[3] = {joystick->deadzone_size, joystick->clampzone_size, outer_radius};
+    SDL_Color colors[3] = {deadzone_color, clampzone_color, outer_color};
+    for (int ring = 0; ring < 3; ring++) {
+        if (radii[ring] <= 0.0f) continue;
+        for (int i = 0; i <= VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS; i++) {
+            float angle = 2.0f * 3.14159265f * i / VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS;
+            points[i] = (SDL_FPoint){center.x + cosf(angle) * radii[ring], center.y + sinf(angle) * radii[ring]};
+        }
+        SDL_SetRenderDrawColor(renderer, colors[ring].r, colors[ring].g, colors[ring].b, colors[ring].a);
+        SDL_RenderDrawLinesF(renderer, points, VIRTUAL_JOYSTICK_CIRCLE_SEGMENTS + 1);
+    }
+    for (int i = 0; i < joystick->_touch_history_count; i++) {
+        points[i] = joystick->_touch_history[(joystick->_touch_history_start + i) % VIRTUAL_JOYSTICK_TOUCH_HISTORY];
+    }
+    SDL_SetRenderDrawColor(renderer, path_color.r, path_color.g, path_color.b, path_color.a);
+    SDL_RenderDrawLinesF(renderer, points, joystick->_touch_history_count);
+    SDL_SetRenderDrawColor(renderer, output_color.r, output_color.g, output_color.b, output_color.a);
+    SDL_RenderDrawLineF(renderer, center.x, center.y, output_end.x, output_end.y);
+    SDL_SetRenderDrawColor(renderer, r, g, b, a);
+#endif
+}
 
-    joystick->is_pressed = false;
-    joystick->output = (Vector2){0.0f, 0.0f};
-    joystick->_touch_index = -1;
+// --- Helper Function: _create_hud_layer ---
+// Creates the HUD's cached layer texture, if the renderer supports render targets.
+// The layer holds premultiplied colors (see _render_hud_region), so it must be composited with
+// a premultiplied blend mode. Renderers without one (such as the software renderer) get no
+// layer and draw every control directly.
+static inline void _create_hud_layer(VirtualJoystickHUD* hud) {
+    hud->_layer = NULL;
+    if (!SDL_RenderTargetSupported(hud->renderer) || hud->width <= 0 || hud->height <= 0) return;
 
-    // Calculate radii for base and tip based on the joystick area size.
-    joystick->_base_radius = (int)(fmin(width, height) * 0.25f);
-    joystick->_tip_radius = (int)(joystick->_base_radius * 0.6f);
+    hud->_layer = _create_texture(hud->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, hud->width, hud->height);
+    if (!hud->_layer) {
+        fprintf(stderr, "Failed to create HUD layer, drawing controls directly: %s\n", SDL_GetError());
+        return;
+    }
+    if (SDL_SetTextureBlendMode(hud->_layer, _premultiplied_blend_mode()) != 0) {
+        _destroy_texture(hud->_layer);
+        hud->_layer = NULL;
+        return;
+    }
+    hud->_full_redraw = true;
+}
 
-    // Create textures for the base and tip.
-    joystick->_default_tip_color = (SDL_Color){200, 200, 200, 180}; // Light gray, semi-transparent
-    joystick->_base_texture = create_circle_texture(renderer, joystick->_base_radius, (SDL_Color){50, 50, 50, 180}); // Dark gray, semi-transparent
-    joystick->_tip_texture = create_circle_texture(renderer, joystick->_tip_radius, joystick->_default_tip_color);
+// --- Helper Function: _render_hud_region ---
+// Clears one region of the HUD layer and re-renders the idle controls that overlap it.
+// The renderer's target must already be the layer. Blending onto a transparent layer leaves
+// premultiplied colors behind, which is why the layer uses a premultiplied blend mode.
+static inline void _render_hud_region(VirtualJoystickHUD* hud, const SDL_Rect* region) {
+    // Clearing needs its own draw state; the app's is put back afterwards.
+    SDL_BlendMode previous_blend_mode;
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawBlendMode(hud->renderer, &previous_blend_mode);
+    SDL_GetRenderDrawColor(hud->renderer, &r, &g, &b, &a);
+    SDL_RenderSetClipRect(hud->renderer, region);
+    SDL_SetRenderDrawBlendMode(hud->renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(hud->renderer, 0, 0, 0, 0);
+    SDL_RenderFillRect(hud->renderer, region);
+    SDL_SetRenderDrawColor(hud->renderer, r, g, b, a);
+    SDL_SetRenderDrawBlendMode(hud->renderer, previous_blend_mode);
 
-    if (!joystick->_base_texture || !joystick->_tip_texture) {
-        VirtualJoystick_Destroy(joystick); // Clean up if texture creation fails.
-        return NULL;
+    for (int i = 0; i < hud->_count; i++) {
+        VirtualJoystickHUDEntry* entry = &hud->_entries[i];
+        if (!entry->in_layer) continue;
+        SDL_Rect bounds;
+        SDL_UnionRect(&entry->base_rect, &entry->tip_rect, &bounds);
+        if (SDL_HasIntersection(&bounds, region)) {
+            _draw_joystick(entry->joystick, hud->renderer); // Overlays are drawn over the layer, not into it.
+            _layer_redraws++;
+        }
     }
+}
 
-    // Set initial default positions for the base and tip.
-    joystick->_base_default_center = (SDL_FPoint){joystick->joystick_area.x + joystick->joystick_area.w / 2.0f,
-                                                  joystick->joystick_area.y + joystick->joystick_area.h / 2.0f};
-    joystick->_base_center = joystick->_base_default_center;
-    joystick->_tip_center = joystick->_base_center; // Initially, tip is at base center.
+// --- Helper Function: _draw_hud_overlays ---
+// Draws the debug overlays of the HUD's controls on top of everything else.
+static inline void _draw_hud_overlays(const VirtualJoystickHUD* hud) {
+    for (int i = 0; i < hud->_count; i++) {
+        if (hud->_entries[i].joystick->debug_overlay) {
+            VirtualJoystick_DrawDebugOverlay(hud->_entries[i].joystick, hud->renderer);
+        }
+    }
+}
 
-    joystick->_hidden = true; // Joystick is hidden by default.
+// --- VirtualJoystickHUD_Create ---
+// Creates a HUD compositor.
+// Parameters:
+//   renderer: The SDL_Renderer the HUD is drawn with.
+//   width, height: Size of the HUD layer, normally the window size.
+// Returns: A pointer to the new VirtualJoystickHUD on success, NULL on failure.
+VIRTUAL_JOYSTICK_API VirtualJoystickHUD* VirtualJoystickHUD_Create(SDL_Renderer* renderer, int width, int height) {
+    VirtualJoystickHUD* hud = (VirtualJoystickHUD*)_joystick_calloc(1, sizeof(VirtualJoystickHUD));
+    if (!hud) {
+        fprintf(stderr, "Failed to allocate VirtualJoystickHUD\n");
+        return NULL;
+    }
+    hud->renderer = renderer;
+    hud->width = width;
+    hud->height = height;
+    hud->_reset_generation = _device_resets + _target_resets;
+    _create_hud_layer(hud);
+    return hud;
+}
 
-    return joystick;
+// --- VirtualJoystickHUD_Destroy ---
+// Frees the HUD compositor. The controls in it are not destroyed.
+VIRTUAL_JOYSTICK_API void VirtualJoystickHUD_Destroy(VirtualJoystickHUD* hud) {
+    if (hud) {
+        if (hud->_layer) {
+            _destroy_texture(hud->_layer);
+        }
+        _joystick_free(hud->_entries);
+        _joystick_free(hud);
+    }
 }
 
-// --- VirtualJoystick_Destroy ---
-// Frees all resources associated with the VirtualJoystick.
-// Parameters:
-//   joystick: A pointer to the VirtualJoystick instance to destroy.
-void VirtualJoystick_Destroy(VirtualJoystick* joystick) {
-    if (joystick) {
-        if (joystick->_base_texture) {
-            SDL_DestroyTexture(joystick->_base_texture);
+// --- VirtualJoystickHUD_AddControl ---
+// Adds a control to the HUD. Controls are drawn in the order they were added.
+// Returns: true on success, false if the allocation failed.
+VIRTUAL_JOYSTICK_API bool VirtualJoystickHUD_AddControl(VirtualJoystickHUD* hud, VirtualJoystick* joystick) {
+    if (hud->_count == hud->_capacity) {
+        int capacity = hud->_capacity ? hud->_capacity * 2 : 8;
+        VirtualJoystickHUDEntry* entries = (VirtualJoystickHUDEntry*)_joystick_realloc(hud->_entries, (size_t)capacity * sizeof(*entries));
+        if (!entries) {
+            fprintf(stderr, "Failed to grow VirtualJoystickHUD\n");
+            return false;
         }
-        if (joystick->_tip_texture) {
-            SDL_DestroyTexture(joystick->_tip_texture);
+        hud->_entries = entries;
+        hud->_capacity = capacity;
+    }
+    VirtualJoystickHUDEntry* entry = &hud->_entries[hud->_count++];
+    SDL_memset(entry, 0, sizeof(*entry));
+    entry->joystick = joystick;
+    hud->_full_redraw = true;
+    return true;
+}
+
+// --- VirtualJoystickHUD_RemoveControl ---
+// Removes a control from the HUD.
+VIRTUAL_JOYSTICK_API void VirtualJoystickHUD_RemoveControl(VirtualJoystickHUD* hud, VirtualJoystick* joystick) {
+    for (int i = 0; i < hud->_count; i++) {
+        if (hud->_entries[i].joystick == joystick) {
+            SDL_memmove(&hud->_entries[i], &hud->_entries[i + 1], (size_t)(hud->_count - i - 1) * sizeof(*hud->_entries));
+            hud->_count--;
+            hud->_full_redraw = true;
+            return;
         }
-        free(joystick);
     }
 }
 
-// --- VirtualJoystick_SetWindowSize ---
-// Updates the stored window dimensions within the joystick.
-// Parameters:
-//   joystick: A pointer to the VirtualJoystick instance.
-//   width: The new width of the window.
-//   height: The new height of the window.
-void VirtualJoystick_SetWindowSize(VirtualJoystick* joystick, int width, int height) {
-    if (joystick) {
-        joystick->_window_width = width;
-        joystick->_window_height = height;
+// --- VirtualJoystickHUD_SetSize ---
+// Resizes the HUD layer, e.g. after the window was resized.
+VIRTUAL_JOYSTICK_API void VirtualJoystickHUD_SetSize(VirtualJoystickHUD* hud, int width, int height) {
+    if (hud->width == width && hud->height == height) return;
+    hud->width = width;
+    hud->height = height;
+    if (hud->_layer) {
+        _destroy_texture(hud->_layer);
     }
+    _create_hud_layer(hud);
 }
 
-// --- VirtualJoystick_HandleEvent ---
-// Processes SDL events relevant to the joystick (touch input).
-// Parameters:
-//   joystick: A pointer to the VirtualJoystick instance.
-//   event: A pointer to the SDL_Event to process.
-void VirtualJoystick_HandleEvent(VirtualJoystick* joystick, const SDL_Event* event) {
-    // If the joystick is hidden, only process SDL_FINGERDOWN to make it appear.
-    if (joystick->_hidden && event->type != SDL_FINGERDOWN) return;
+// --- VirtualJoystickHUD_Draw ---
+// Draws all controls of the HUD. Idle controls that changed since the last call are re-rendered
+// into the cached layer, the layer is copied to the screen, and active controls are drawn on top.
+// Debug overlays are never cached: they are drawn last, for every control that has one enabled.
+VIRTUAL_JOYSTICK_API void VirtualJoystickHUD_Draw(VirtualJoystickHUD* hud) {
+    SDL_Renderer* renderer = hud->renderer;
 
-    switch (event->type) {
-        case SDL_FINGERDOWN: {
-            // Convert normalized touch coordinates (0.0 to 1.0) to screen pixel coordinates.
-            SDL_FPoint touch_pos = {(float)event->tfinger.x * joystick->_window_width,
-                                    (float)event->tfinger.y * joystick->_window_height};
+    // Renderer resets lose the layer's contents too; a device reset also invalidates the texture.
+    int reset_generation = _device_resets + _target_resets;
+    if (hud->_reset_generation != reset_generation) {
+        hud->_reset_generation = reset_generation;
+        if (hud->_layer) {
+            _destroy_texture(hud->_layer);
+        }
+        _create_hud_layer(hud);
+    }
 
-            // Check if the touch is within the joystick's interaction area and no other finger is tracking it.
-            if (_is_point_inside_joystick_area(joystick, touch_pos) && joystick->_touch_index == -1) {
-                bool should_activate = false;
-                if (joystick->joystick_mode == JOYSTICK_MODE_DYNAMIC || joystick->joystick_mode == JOYSTICK_MODE_FOLLOWING) {
-                    should_activate = true;
-                } else if (joystick->joystick_mode == JOYSTICK_MODE_FIXED && _is_point_inside_base(joystick, touch_pos)) {
-                    should_activate = true;
-                }
+    // Without a layer (see _create_hud_layer) every control is drawn directly.
+    if (!hud->_layer) {
+        for (int i = 0; i < hud->_count; i++) {
+            if (!hud->_entries[i].joystick->_hidden) _draw_joystick(hud->_entries[i].joystick, renderer);
+        }
+        _draw_hud_overlays(hud);
+        return;
+    }
 
-                if (should_activate) {
-                    // In DYNAMIC/FOLLOWING mode, move the base to the touch position.
-                    if (joystick->joystick_mode == JOYSTICK_MODE_DYNAMIC || joystick->joystick_mode == JOYSTICK_MODE_FOLLOWING) {
-                        _move_base(joystick, touch_pos);
-                    }
-                    joystick->_touch_index = event->tfinger.fingerId; // Start tracking this finger.
-                    joystick->_hidden = false; // Make the joystick visible.
-                    // Change tip color to indicate pressed state.
-                    SDL_SetTextureColorMod(joystick->_tip_texture, joystick->pressed_color.r, joystick->pressed_color.g, joystick->pressed_color.b);
-                    _update_joystick_logic(joystick, touch_pos); // Update joystick state immediately.
-                }
-            }
-            break;
+    // Compare each control with what was last composited and re-render the regions that changed.
+    SDL_Texture* previous_target = NULL;
+    bool layer_bound = false;
+    for (int i = 0; i < hud->_count; i++) {
+        VirtualJoystickHUDEntry* entry = &hud->_entries[i];
+        const VirtualJoystick* joystick = entry->joystick;
+
+        VirtualJoystickHUDEntry current = *entry;
+        current.hidden = joystick->_hidden;
+        current.active = joystick->_touch_index != -1;
+        current.in_layer = !current.hidden && !current.active;
+        _get_draw_sources(joystick, &current.base_bitmap, &current.base_src, &current.tip_bitmap, &current.tip_src, &current.tip_color);
+        _get_draw_rects(joystick, &current.base_rect, &current.tip_rect);
+
+        // Colors are baked into the circle bitmaps, so a new skin or color shows up as a new source.
+        bool changed = current.in_layer != entry->in_layer ||
+                       (current.in_layer && (SDL_memcmp(&current.base_rect, &entry->base_rect, sizeof(SDL_Rect)) != 0 ||
+                                             SDL_memcmp(&current.tip_rect, &entry->tip_rect, sizeof(SDL_Rect)) != 0 ||
+                                             SDL_memcmp(&current.tip_color, &entry->tip_color, sizeof(SDL_Color)) != 0 ||
+                                             current.base_bitmap != entry->base_bitmap || current.tip_bitmap != entry->tip_bitmap ||
+                                             current.base_src != entry->base_src || current.tip_src != entry->tip_src));
+
+        // The damaged region covers where the control was and where it is now.
+        SDL_Rect damage = {0, 0, 0, 0};
+        if (entry->in_layer) {
+            SDL_UnionRect(&entry->base_rect, &entry->tip_rect, &damage);
         }
-        case SDL_FINGERUP: {
-            // If the released finger is the one tracking the joystick, reset the joystick.
-            if (event->tfinger.fingerId == joystick->_touch_index) {
-                _reset_joystick(joystick);
+        *entry = current;
+        if (!changed || hud->_full_redraw) continue;
+        if (current.in_layer) {
+            SDL_Rect bounds;
+            SDL_UnionRect(&current.base_rect, &current.tip_rect, &bounds);
+            if (damage.w > 0 && damage.h > 0) {
+                SDL_UnionRect(&damage, &bounds, &damage);
+            } else {
+                damage = bounds;
             }
-            break;
         }
-        case SDL_FINGERMOTION: {
-            // If the moving finger is the one tracking the joystick, update its state.
-            if (event->tfinger.fingerId == joystick->_touch_index) {
-                SDL_FPoint touch_pos = {(float)event->tfinger.x * joystick->_window_width,
-                                        (float)event->tfinger.y * joystick->_window_height};
-                _update_joystick_logic(joystick, touch_pos);
-            }
-            break;
+
+        if (!layer_bound) {
+            previous_target = SDL_GetRenderTarget(renderer);
+            SDL_SetRenderTarget(renderer, hud->_layer);
+            layer_bound = true;
+        }
+        _render_hud_region(hud, &damage);
+    }
+
+    if (hud->_full_redraw) {
+        if (!layer_bound) {
+            previous_target = SDL_GetRenderTarget(renderer);
+            SDL_SetRenderTarget(renderer, hud->_layer);
+            layer_bound = true;
         }
+        SDL_Rect whole_layer = {0, 0, hud->width, hud->height};
+        _render_hud_region(hud, &whole_layer);
+        hud->_full_redraw = false;
     }
+    if (layer_bound) {
+        SDL_RenderSetClipRect(renderer, NULL);
+        SDL_SetRenderTarget(renderer, previous_target);
+    }
+
+    // One copy for all idle controls, then the controls being touched on top, then the overlays.
+    SDL_RenderCopy(renderer, hud->_layer, NULL, NULL);
+    for (int i = 0; i < hud->_count; i++) {
+        if (hud->_entries[i].active && !hud->_entries[i].hidden) {
+            _draw_joystick(hud->_entries[i].joystick, renderer);
+        }
+    }
+    _draw_hud_overlays(hud);
 }
 
-// --- VirtualJoystick_Draw ---
-// Renders the joystick onto the screen.
+// --- Helper Function: _compare_draw_commands ---
+// qsort comparator ordering draw commands by z_order, layer, bitmap, color and insertion order.
+static int _compare_draw_commands(const void* a, const void* b) {
+    const VirtualJoystickDrawCommand* lhs = (const VirtualJoystickDrawCommand*)a;
+    const VirtualJoystickDrawCommand* rhs = (const VirtualJoystickDrawCommand*)b;
+    if (lhs->z_order != rhs->z_order) return lhs->z_order < rhs->z_order ? -1 : 1;
+    if (lhs->layer != rhs->layer) return lhs->layer < rhs->layer ? -1 : 1;
+    if (lhs->bitmap != rhs->bitmap) return (uintptr_t)lhs->bitmap < (uintptr_t)rhs->bitmap ? -1 : 1;
+    Uint32 lhs_color = ((Uint32)lhs->color_mod.r << 16) | ((Uint32)lhs->color_mod.g << 8) | lhs->color_mod.b;
+    Uint32 rhs_color = ((Uint32)rhs->color_mod.r << 16) | ((Uint32)rhs->color_mod.g << 8) | rhs->color_mod.b;
+    if (lhs_color != rhs_color) return lhs_color < rhs_color ? -1 : 1;
+    return lhs->sequence - rhs->sequence;
+}
+
+// --- Helper Function: _push_draw_command ---
+// Appends one command to a draw list, growing it if needed.
+// Returns: true on success, false if the allocation failed.
+static inline bool _push_draw_command(VirtualJoystickDrawList* list, const VirtualJoystickBitmap* bitmap, const SDL_Rect* src_rect,
+                                      const SDL_Rect* dst_rect, SDL_Color color_mod, int z_order, int layer) {
+    if (list->_count == list->_capacity) {
+        int capacity = list->_capacity ? list->_capacity * 2 : 16;
+        VirtualJoystickDrawCommand* commands = (VirtualJoystickDrawCommand*)_joystick_realloc(list->_commands, (size_t)capacity * sizeof(*commands));
+        if (!commands) {
+            fprintf(stderr, "Failed to grow VirtualJoystickDrawList\n");
+            return false;
+        }
+        list->_commands = commands;
+        list->_capacity = capacity;
+    }
+    VirtualJoystickDrawCommand* command = &list->_commands[list->_count];
+    command->bitmap = bitmap;
+    command->src_rect = src_rect ? *src_rect : (SDL_Rect){0, 0, bitmap->width, bitmap->height};
+    command->dst_rect = *dst_rect;
+    command->color_mod = color_mod;
+    command->z_order = z_order;
+    command->layer = layer;
+    command->sequence = list->_count;
+    list->_count++;
+    return true;
+}
+
+// --- VirtualJoystickDrawList_Create ---
+// Creates an empty draw list.
+// Returns: A pointer to the new VirtualJoystickDrawList on success, NULL on failure.
+VIRTUAL_JOYSTICK_API VirtualJoystickDrawList* VirtualJoystickDrawList_Create(void) {
+    VirtualJoystickDrawList* list = (VirtualJoystickDrawList*)_joystick_calloc(1, sizeof(VirtualJoystickDrawList));
+    if (!list) {
+        fprintf(stderr, "Failed to allocate VirtualJoystickDrawList\n");
+    }
+    return list;
+}
+
+// --- VirtualJoystickDrawList_Destroy ---
+// Frees a draw list.
+VIRTUAL_JOYSTICK_API void VirtualJoystickDrawList_Destroy(VirtualJoystickDrawList* list) {
+    if (list) {
+        _joystick_free(list->_commands);
+        _joystick_free(list);
+    }
+}
+
+// --- VirtualJoystickDrawList_Clear ---
+// Removes all collected commands, keeping the allocated storage for the next frame.
+VIRTUAL_JOYSTICK_API void VirtualJoystickDrawList_Clear(VirtualJoystickDrawList* list) {
+    list->_count = 0;
+}
+
+// --- VirtualJoystickDrawList_AddControl ---
+// Collects the draw commands of a joystick (nothing if it is hidden).
+// Returns: true on success, false if the allocation failed.
+VIRTUAL_JOYSTICK_API bool VirtualJoystickDrawList_AddControl(VirtualJoystickDrawList* list, const VirtualJoystick* joystick) {
+    if (joystick->_hidden) return true;
+
+    SDL_Rect base_dst_rect, tip_dst_rect;
+    _get_draw_rects(joystick, &base_dst_rect, &tip_dst_rect);
+    const VirtualJoystickBitmap* base_bitmap;
+    const VirtualJoystickBitmap* tip_bitmap;
+    const SDL_Rect* base_src_rect;
+    const SDL_Rect* tip_src_rect;
+    SDL_Color tip_color;
+    _get_draw_sources(joystick, &base_bitmap, &base_src_rect, &tip_bitmap, &tip_src_rect, &tip_color);
+    return _push_draw_command(list, base_bitmap, base_src_rect, &base_dst_rect, (SDL_Color){255, 255, 255, 255}, joystick->z_order, 0) &&
+           _push_draw_command(list, tip_bitmap, tip_src_rect, &tip_dst_rect, tip_color, joystick->z_order, 1);
+}
+
+// --- VirtualJoystickDrawList_Submit ---
+// Sorts the collected commands and draws them, only switching texture or color modulation when
+// the next command needs a different one. The number of switches is kept in list->state_changes
+// and reported by VirtualJoystick_GetStats. The list is not cleared.
 // Parameters:
-//   joystick: A pointer to the VirtualJoystick instance.
+//   list: The draw list to submit.
 //   renderer: The SDL_Renderer to draw with.
-void VirtualJoystick_Draw(VirtualJoystick* joystick, SDL_Renderer* renderer) {
-    if (joystick->_hidden) return; // Don't draw if hidden.
+VIRTUAL_JOYSTICK_API void VirtualJoystickDrawList_Submit(VirtualJoystickDrawList* list, SDL_Renderer* renderer) {
+    list->state_changes = 0;
+    VirtualJoystickTextureSet* set = _get_texture_set(renderer, false);
+    if (!set || list->_count == 0) {
+        _last_state_changes = 0;
+        return;
+    }
+    SDL_qsort(list->_commands, (size_t)list->_count, sizeof(VirtualJoystickDrawCommand), _compare_draw_commands);
 
-    // Calculate destination rectangle for the base texture.
-    SDL_Rect base_dst_rect = {
-        (int)(joystick->_base_center.x - joystick->_base_radius),
-        (int)(joystick->_base_center.y - joystick->_base_radius),
-        joystick->_base_radius * 2,
-        joystick->_base_radius * 2
-    };
-    // Render the base texture.
-    SDL_RenderCopy(renderer, joystick->_base_texture, NULL, &base_dst_rect);
+    SDL_Texture* current_texture = NULL;
+    SDL_Color current_color = {0, 0, 0, 0};
+    for (int i = 0; i < list->_count; i++) {
+        const VirtualJoystickDrawCommand* command = &list->_commands[i];
+        if (set->backend == JOYSTICK_BACKEND_GEOMETRY && !command->bitmap->pixels) {
+            _draw_bitmap(set, command->bitmap, NULL, &command->dst_rect, command->color_mod);
+            continue;
+        }
 
-    // Calculate destination rectangle for the tip texture.
-    SDL_Rect tip_dst_rect = {
-        (int)(joystick->_tip_center.x - joystick->_tip_radius),
-        (int)(joystick->_tip_center.y - joystick->_tip_radius),
-        joystick->_tip_radius * 2,
-        joystick->_tip_radius * 2
-    };
-    // Render the tip texture.
-    SDL_RenderCopy(renderer, joystick->_tip_texture, NULL, &tip_dst_rect);
+        SDL_Texture* texture = _get_bitmap_texture(set, command->bitmap);
+        if (!texture) continue;
+        bool same_color = command->color_mod.r == current_color.r && command->color_mod.g == current_color.g &&
+                          command->color_mod.b == current_color.b;
+        if (texture != current_texture) {
+            current_texture = texture;
+            list->state_changes++;
+            // The texture may still carry a color from another draw, so always set it on a switch.
+            SDL_SetTextureColorMod(texture, command->color_mod.r, command->color_mod.g, command->color_mod.b);
+            current_color = command->color_mod;
+        } else if (!same_color) {
+            list->state_changes++;
+            SDL_SetTextureColorMod(texture, command->color_mod.r, command->color_mod.g, command->color_mod.b);
+            current_color = command->color_mod;
+        }
+        SDL_RenderCopy(renderer, texture, &command->src_rect, &command->dst_rect);
+    }
+    _last_state_changes = list->state_changes;
 }
 
 // --- Main Application Entry Point ---
-// This main function is included only if VIRTUAL_JOYSTICK_IMPLEMENTATION is defined.
+// This main function is included only if VIRTUAL_JOYSTICK_DEMO is defined.
 // This allows the header to be compiled directly as an executable.
-#ifndef VIRTUAL_JOYSTICK_NO_MAIN // Allows users to exclude main if they define their own
+#ifdef VIRTUAL_JOYSTICK_DEMO // Opt-in, so programs with their own main never get this one
+#include <time.h> // For clock, to report the demo's CPU time
+
 int main(int argc, char* args[]) {
     // Initialize SDL subsystems (Video and Events are needed for graphics and input).
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS) < 0) {
@@ -445,6 +4748,9 @@ int main(int argc, char* args[]) {
     int joystick_area_x = 0;
     int joystick_area_y = 0;
 
+    // With --trace (and VIRTUAL_JOYSTICK_TRACE compiled in), record a timeline written on exit.
+    bool trace = argc > 1 && SDL_strcmp(args[1], "--trace") == 0 && VirtualJoystick_StartTrace();
+
     // Create the Virtual Joystick instance, passing window dimensions.
     VirtualJoystick* joystick = VirtualJoystick_Create(renderer, joystick_area_x, joystick_area_y, joystick_area_width, joystick_area_height, win_width, win_height);
     if (!joystick) {
@@ -454,18 +4760,49 @@ int main(int argc, char* args[]) {
         return 1;
     }
 
+    // Report which draw backend was picked for this renderer.
+    VirtualJoystickStats stats;
+    VirtualJoystick_GetStats(renderer, &stats);
+    printf("Joystick draw backend: %d\n", (int)stats.backend);
+
     // Customize joystick properties for demonstration.
     joystick->joystick_mode = JOYSTICK_MODE_DYNAMIC; // Dynamic mode for appearance on touch.
     joystick->clampzone_size = 100.0f;
     joystick->deadzone_size = 20.0f;
+    joystick->return_spring_frequency = 4.0f; // Let the tip spring back to the base on release.
+    joystick->input_sources |= JOYSTICK_INPUT_MOUSE | JOYSTICK_INPUT_KEYBOARD; // Allow testing on desktops.
+
+    // With --shm, publish the joystick state for virtual_joystick_shm_reader.c.
+    if (argc > 1 && SDL_strcmp(args[1], "--shm") == 0) {
+        VirtualJoystick_PublishShared(joystick, "/virtual_joystick_demo");
+    }
+
+    // With --poll, run the old loop that polls and redraws every frame, to compare its CPU time
+    // and wakeups (printed on exit) with the default loop that sleeps while idle.
+    bool poll_events = argc > 1 && SDL_strcmp(args[1], "--poll") == 0;
 
     bool quit = false; // Flag to control the main game loop.
     SDL_Event e;       // SDL event structure to hold incoming events.
+    Uint32 last_ticks = SDL_GetTicks(); // Time of the previous frame, for animations.
 
     // --- Main Game Loop ---
+    Uint32 wakeups = 0;        // Loop iterations, to show how rarely the demo wakes up while idle.
+    Uint32 start_ticks = SDL_GetTicks();
+    clock_t start_cpu = clock();
+
     while (!quit) {
+        // Sleep until input arrives, or until the next animation step while the joystick
+        // animates. Nothing else redraws the window, so an idle demo does not use any CPU.
+        // A timeout of 0 polls, and the loop is then paced by the vsync of SDL_RenderPresent.
+        int timeout = poll_events ? 0 : VirtualJoystick_GetUpdateTimeout(&joystick, 1);
+        bool has_event = SDL_WaitEventTimeout(&e, timeout) != 0;
+        if (timeout < 0) {
+            last_ticks = SDL_GetTicks(); // Time spent asleep while idle is not animation time.
+        }
+        wakeups++;
+
         // Event processing loop.
-        while (SDL_PollEvent(&e) != 0) {
+        for (; has_event; has_event = SDL_PollEvent(&e) != 0) {
             // Check for quit event (e.g., closing the window).
             if (e.type == SDL_QUIT) {
                 quit = true;
@@ -482,10 +4819,19 @@ int main(int argc, char* args[]) {
                                                               joystick->joystick_area.y + joystick->joystick_area.h / 2.0f};
                 _reset_joystick(joystick); // Reset joystick and hide it after resize.
             }
+            // Toggle the debug overlay with F1.
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F1) {
+                joystick->debug_overlay = !joystick->debug_overlay;
+            }
             // Pass all events to the joystick for its internal handling.
             VirtualJoystick_HandleEvent(joystick, &e);
         }
 
+        // Advance the joystick's animations by the time since the previous frame.
+        Uint32 ticks = SDL_GetTicks();
+        VirtualJoystick_Update(joystick, (ticks - last_ticks) / 1000.0f);
+        last_ticks = ticks;
+
         // --- Rendering ---
         // Set the drawing color to black and clear the renderer (background).
         SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xFF);
@@ -503,10 +4849,17 @@ int main(int argc, char* args[]) {
         SDL_RenderPresent(renderer);
     }
 
+    printf("\nWakeups: %u, CPU time: %.2f s in %.1f s\n", (unsigned)wakeups, (double)(clock() - start_cpu) / CLOCKS_PER_SEC,
+           (SDL_GetTicks() - start_ticks) / 1000.0);
+    if (trace && VirtualJoystick_WriteTrace("joystick_trace.json")) {
+        printf("Trace written to joystick_trace.json (open it in chrome://tracing or ui.perfetto.dev)\n");
+    }
+
     // --- Cleanup ---
     // Destroy the VirtualJoystick instance.
     VirtualJoystick_Destroy(joystick);
-    // Destroy the renderer.
+    // Release any textures the joysticks still hold on the renderer, then destroy it.
+    VirtualJoystick_ReleaseRenderer(renderer);
     SDL_DestroyRenderer(renderer);
     // Destroy the window.
     SDL_DestroyWindow(window);
@@ -515,13 +4868,11 @@ int main(int argc, char* args[]) {
 
     return 0;
 }
-#endif // VIRTUAL_JOYSTICK_NO_MAIN
-
-#endif // VIRTUAL_JOYSTICK_IMPLEMENTATION
+#endif // VIRTUAL_JOYSTICK_DEMO
 
 #ifdef __cplusplus
 } // extern "C"
 #endif
 
-#endif // VIRTUAL_JOYSTICK_H
+#endif // VIRTUAL_JOYSTICK_IMPLEMENTATION_INCLUDED
 
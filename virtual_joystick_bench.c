@@ -0,0 +1,476 @@
+// Benchmarks for the SDL2 virtual joystick.
+// Runs the library's hot paths in tight loops and prints the time per operation, so a change can
+// be compared with the previous build on the same machine. Controls are created on SDL's software
+// renderer, so no window or GPU is needed.
+//
+// Build and run:
+//   gcc -O2 virtual_joystick_bench.c -o joystick_bench -lSDL2 -lm
+//   ./joystick_bench            (every benchmark)
+//   ./joystick_bench deadzone   (only the named ones)
+//
+// By default the library is compiled into this file. To compare the other ways of building it
+// (see Build Configuration in the header), build with -DVIRTUAL_JOYSTICK_STATIC to make every
+// function static inline, or with JOYSTICK_BENCH_SEPARATE and the library in its own object file:
+//   gcc -O2 -x c -DVIRTUAL_JOYSTICK_IMPLEMENTATION -c virtual_joyistick_asets.h -o virtual_joystick.o
+//   gcc -O2 -DJOYSTICK_BENCH_SEPARATE virtual_joystick_bench.c virtual_joystick.o -o joystick_bench -lSDL2 -lm
+
+#ifndef JOYSTICK_BENCH_SEPARATE
+#define VIRTUAL_JOYSTICK_IMPLEMENTATION
+#endif
+#include "virtual_joyistick_asets.h"
+
+#include <string.h>
+
+#define BENCH_SAMPLES 65536 // Samples in one pass of a drag.
+#define BENCH_ROUNDS 16     // Passes over the drag per measurement.
+#define BENCH_REPEATS 9     // Measurements per result; the fastest is reported, as it has the least noise.
+
+// --- Helper Function: seconds_since ---
+// Returns: Seconds elapsed since a performance counter value.
+static double seconds_since(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+// --- Helper Function: make_drag ---
+// Fills samples with a finger circling a center while its distance sweeps from 0 to 1.2 times
+// radius, so every zone of a stick (deadzone, live range, outer deadzone, clamp) is crossed.
+static void make_drag(VirtualJoystickTouchSample* samples, int count, SDL_FPoint center, float radius) {
+    for (int i = 0; i < count; i++) {
+        float angle = i * 0.0137f;
+        float distance = radius * 1.2f * (float)(i % 1024) / 1023.0f;
+        samples[i].phase = JOYSTICK_TOUCH_MOVE;
+        samples[i].finger_id = 1;
+        samples[i].x = center.x + cosf(angle) * distance;
+        samples[i].y = center.y + sinf(angle) * distance;
+        samples[i].timestamp = (Uint32)i;
+    }
+}
+
+// --- Helper Function: run_drag ---
+// Touches the stick down at its center, feeds the drag one sample at a time (the per-event
+// path) and lifts the finger again.
+// Returns: Nanoseconds per sample (the fastest of BENCH_REPEATS measurements).
+static double run_drag(VirtualJoystick* joystick, const VirtualJoystickTouchSample* samples, int count) {
+    VirtualJoystickTouchSample down = {JOYSTICK_TOUCH_DOWN, 1, joystick->_base_default_center.x, joystick->_base_default_center.y, 0};
+    VirtualJoystickTouchSample up = down;
+    up.phase = JOYSTICK_TOUCH_UP;
+    double best = 0.0;
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        VirtualJoystick_InjectSample(joystick, &down);
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            for (int i = 0; i < count; i++) {
+                VirtualJoystick_InjectSample(joystick, &samples[i]);
+            }
+        }
+        double elapsed = seconds_since(start);
+        VirtualJoystick_InjectSample(joystick, &up);
+        if (repeat == 0 || elapsed < best) best = elapsed;
+    }
+    return best * 1e9 / ((double)count * BENCH_ROUNDS);
+}
+
+// --- Benchmark: deadzone ---
+// Cost of one motion sample for each deadzone shape, alone and with the outer deadzone and axis
+// snapping on top. SCALED_RADIAL without extras is the original path.
+static void bench_deadzone(SDL_Renderer* renderer) {
+    static const struct {
+        const char* name;
+        JoystickDeadzone shape;
+    } shapes[] = {
+        {"scaled radial", JOYSTICK_DEADZONE_SCALED_RADIAL},
+        {"radial", JOYSTICK_DEADZONE_RADIAL},
+        {"axial", JOYSTICK_DEADZONE_AXIAL},
+        {"cross", JOYSTICK_DEADZONE_CROSS},
+    };
+    VirtualJoystick* joystick = VirtualJoystick_Create(renderer, 0, 0, 400, 400, 800, 600);
+    VirtualJoystickTouchSample* samples = (VirtualJoystickTouchSample*)malloc(BENCH_SAMPLES * sizeof(*samples));
+    if (!joystick || !samples) {
+        fprintf(stderr, "deadzone: setup failed\n");
+        VirtualJoystick_Destroy(joystick);
+        free(samples);
+        return;
+    }
+    make_drag(samples, BENCH_SAMPLES, joystick->_base_default_center, joystick->clampzone_size);
+
+    printf("deadzone (ns per motion sample)\n");
+    printf("  %-14s %10s %10s %10s %10s\n", "shape", "plain", "+outer", "+snap", "+both");
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        double ns[4];
+        for (int extras = 0; extras < 4; extras++) {
+            joystick->deadzone_shape = shapes[s].shape;
+            joystick->outer_deadzone_size = (extras & 1) ? 10.0f : 0.0f;
+            joystick->snap_angle = (extras & 2) ? 10.0f : 0.0f;
+            ns[extras] = run_drag(joystick, samples, BENCH_SAMPLES);
+        }
+        printf("  %-14s %10.1f %10.1f %10.1f %10.1f\n", shapes[s].name, ns[0], ns[1], ns[2], ns[3]);
+    }
+
+    free(samples);
+    VirtualJoystick_Destroy(joystick);
+}
+
+// --- Benchmark: inject ---
+// Throughput of the same drag through the event path (building SDL_FINGERMOTION events with
+// normalized coordinates for VirtualJoystick_HandleEvent, as a bot without the injection API
+// would) and through VirtualJoystick_InjectSample and VirtualJoystick_InjectSamples.
+static void bench_inject(SDL_Renderer* renderer) {
+    const int window_width = 800, window_height = 600;
+    VirtualJoystick* joystick = VirtualJoystick_Create(renderer, 0, 0, 400, 400, window_width, window_height);
+    VirtualJoystickTouchSample* samples = (VirtualJoystickTouchSample*)malloc(BENCH_SAMPLES * sizeof(*samples));
+    if (!joystick || !samples) {
+        fprintf(stderr, "inject: setup failed\n");
+        VirtualJoystick_Destroy(joystick);
+        free(samples);
+        return;
+    }
+    make_drag(samples, BENCH_SAMPLES, joystick->_base_default_center, joystick->clampzone_size);
+    VirtualJoystickTouchSample down = {JOYSTICK_TOUCH_DOWN, 1, joystick->_base_default_center.x, joystick->_base_default_center.y, 0};
+    VirtualJoystickTouchSample up = down;
+    up.phase = JOYSTICK_TOUCH_UP;
+
+    double best[3] = {0.0, 0.0, 0.0};
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        double elapsed[3];
+        for (int path = 0; path < 3; path++) {
+            VirtualJoystick_InjectSample(joystick, &down);
+            Uint64 start = SDL_GetPerformanceCounter();
+            for (int round = 0; round < BENCH_ROUNDS; round++) {
+                if (path == 0) {
+                    for (int i = 0; i < BENCH_SAMPLES; i++) {
+                        SDL_Event event;
+                        SDL_memset(&event, 0, sizeof(event));
+                        event.type = SDL_FINGERMOTION;
+                        event.tfinger.timestamp = samples[i].timestamp;
+                        event.tfinger.fingerId = samples[i].finger_id;
+                        event.tfinger.x = samples[i].x / window_width;
+                        event.tfinger.y = samples[i].y / window_height;
+                        VirtualJoystick_HandleEvent(joystick, &event);
+                    }
+                } else if (path == 1) {
+                    for (int i = 0; i < BENCH_SAMPLES; i++) {
+                        VirtualJoystick_InjectSample(joystick, &samples[i]);
+                    }
+                } else {
+                    VirtualJoystick_InjectSamples(joystick, samples, BENCH_SAMPLES);
+                }
+            }
+            elapsed[path] = seconds_since(start);
+            VirtualJoystick_InjectSample(joystick, &up);
+        }
+        for (int path = 0; path < 3; path++) {
+            if (repeat == 0 || elapsed[path] < best[path]) best[path] = elapsed[path];
+        }
+    }
+
+    static const char* names[3] = {"HandleEvent", "InjectSample", "InjectSamples"};
+    double total = (double)BENCH_SAMPLES * BENCH_ROUNDS;
+    printf("inject (same drag through each path)\n");
+    for (int path = 0; path < 3; path++) {
+        printf("  %-14s %8.1f ns/sample %8.1f M samples/s %6.2fx\n", names[path], best[path] * 1e9 / total,
+               total / best[path] / 1e6, best[0] / best[path]);
+    }
+
+    free(samples);
+    VirtualJoystick_Destroy(joystick);
+}
+
+// --- Helper Function: custom_source ---
+// Custom input source for the sources benchmark: SDL_USEREVENT events carry the index of a
+// prepared sample in user.code.
+static const VirtualJoystickTouchSample* custom_samples = NULL;
+static int custom_source(VirtualJoystick* joystick, const SDL_Event* event, VirtualJoystickTouchSample* samples) {
+    (void)joystick;
+    samples[0] = custom_samples[event->user.code];
+    return 1;
+}
+
+// --- Benchmark: sources ---
+// Cost of one event through VirtualJoystick_HandleEvent for each input source: touch, mouse
+// drags, keyboard presses (each press or release yields one or two samples), a custom source
+// registered with VirtualJoystick_SetInputSource, and an event no source handles (the cost of
+// the table lookup alone).
+static void bench_sources(SDL_Renderer* renderer) {
+    const int window_width = 800, window_height = 600;
+    const int count = BENCH_SAMPLES + 2; // Touching down, the drag, and lifting the finger.
+    VirtualJoystick* joystick = VirtualJoystick_Create(renderer, 0, 0, 400, 400, window_width, window_height);
+    VirtualJoystickTouchSample* samples = (VirtualJoystickTouchSample*)malloc((size_t)count * sizeof(*samples));
+    SDL_Event* events = (SDL_Event*)calloc((size_t)count, sizeof(*events));
+    if (!joystick || !samples || !events) {
+        fprintf(stderr, "sources: setup failed\n");
+        VirtualJoystick_Destroy(joystick);
+        free(samples);
+        free(events);
+        return;
+    }
+    joystick->input_sources = JOYSTICK_INPUT_TOUCH | JOYSTICK_INPUT_MOUSE | JOYSTICK_INPUT_KEYBOARD | JOYSTICK_INPUT_CUSTOM;
+    make_drag(samples + 1, BENCH_SAMPLES, joystick->_base_default_center, joystick->clampzone_size);
+    samples[0] = samples[count - 1] = (VirtualJoystickTouchSample){JOYSTICK_TOUCH_DOWN, 1, joystick->_base_default_center.x, joystick->_base_default_center.y, 0};
+    samples[count - 1].phase = JOYSTICK_TOUCH_UP;
+    custom_samples = samples;
+    VirtualJoystick_SetInputSource(SDL_USEREVENT, custom_source);
+
+    static const char* names[] = {"touch", "mouse", "keyboard", "custom", "unhandled"};
+    printf("sources (ns per event through VirtualJoystick_HandleEvent)\n");
+    for (int source = 0; source < 5; source++) {
+        for (int i = 0; i < count; i++) {
+            SDL_Event* event = &events[i];
+            SDL_memset(event, 0, sizeof(*event));
+            const VirtualJoystickTouchSample* sample = &samples[i];
+            bool first = i == 0, last = i == count - 1;
+            if (source == 0) {
+                event->type = first ? SDL_FINGERDOWN : last ? SDL_FINGERUP : SDL_FINGERMOTION;
+                event->tfinger.fingerId = sample->finger_id;
+                event->tfinger.x = sample->x / window_width;
+                event->tfinger.y = sample->y / window_height;
+            } else if (source == 1 && (first || last)) {
+                event->type = first ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+                event->button.button = SDL_BUTTON_LEFT;
+                event->button.x = (Sint32)sample->x;
+                event->button.y = (Sint32)sample->y;
+            } else if (source == 1) {
+                event->type = SDL_MOUSEMOTION;
+                event->motion.state = SDL_BUTTON_LMASK;
+                event->motion.x = (Sint32)sample->x;
+                event->motion.y = (Sint32)sample->y;
+            } else if (source == 2) {
+                // Alternate presses of D and A (count is even, so every press is released).
+                event->type = (i & 1) ? SDL_KEYUP : SDL_KEYDOWN;
+                event->key.keysym.scancode = (i & 2) ? SDL_SCANCODE_A : SDL_SCANCODE_D;
+            } else if (source == 3) {
+                event->type = SDL_USEREVENT;
+                event->user.code = i;
+            } else {
+                event->type = SDL_JOYAXISMOTION;
+            }
+        }
+
+        double best = 0.0;
+        for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+            Uint64 start = SDL_GetPerformanceCounter();
+            for (int round = 0; round < BENCH_ROUNDS; round++) {
+                for (int i = 0; i < count; i++) {
+                    VirtualJoystick_HandleEvent(joystick, &events[i]);
+                }
+            }
+            double elapsed = seconds_since(start);
+            if (repeat == 0 || elapsed < best) best = elapsed;
+        }
+        printf("  %-10s %8.1f\n", names[source], best * 1e9 / ((double)count * BENCH_ROUNDS));
+    }
+
+    VirtualJoystick_SetInputSource(SDL_USEREVENT, NULL);
+    free(events);
+    free(samples);
+    VirtualJoystick_Destroy(joystick);
+}
+
+// --- Benchmark: prepare ---
+// Wall-clock time of VirtualJoystick_PrepareBitmaps for a set of anti-aliased circles, with one
+// thread and with more. No renderer is passed, so only rasterization is timed; the bitmaps are
+// released between runs so every run rasterizes them again.
+static void bench_prepare(SDL_Renderer* renderer) {
+    (void)renderer;
+    enum { DESC_COUNT = 48 };
+    VirtualJoystickBitmapDesc descs[DESC_COUNT];
+    for (int i = 0; i < DESC_COUNT; i++) {
+        descs[i].radius = 40 + (i % 8) * 20;
+        descs[i].color = (SDL_Color){(Uint8)(i * 40), 128, (Uint8)(255 - i * 5), 255};
+        descs[i].aa_samples = 4;
+    }
+
+    int cpus = SDL_GetCPUCount();
+    int thread_counts[] = {1, 2, 4, cpus};
+    printf("prepare (%d circles, radius 40-180, 4x4 AA; %d CPUs)\n", DESC_COUNT, cpus);
+    printf("  threads       ms  speedup\n");
+    double single = 0.0;
+    for (int t = 0; t < 4; t++) {
+        double best = 0.0;
+        for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+            Uint64 start = SDL_GetPerformanceCounter();
+            bool ok = VirtualJoystick_PrepareBitmaps(NULL, descs, DESC_COUNT, thread_counts[t]);
+            double elapsed = seconds_since(start);
+            VirtualJoystick_ReleasePreparedBitmaps();
+            if (!ok) {
+                fprintf(stderr, "prepare: VirtualJoystick_PrepareBitmaps failed\n");
+                return;
+            }
+            if (repeat == 0 || elapsed < best) best = elapsed;
+        }
+        if (t == 0) single = best;
+        printf("  %7d %8.2f %7.2fx\n", thread_counts[t], best * 1e3, single / best);
+    }
+}
+
+// --- Benchmark: blend ---
+// Texture copy throughput on the benchmark's renderer (the software renderer) for the blend
+// modes the library can pick: SDL_BLENDMODE_BLEND for straight alpha, the premultiplied custom
+// mode where the renderer accepts it, and SDL_BLENDMODE_NONE as the cost of the copy alone.
+static void bench_blend(SDL_Renderer* renderer) {
+    const int size = 128, copies = 512;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_RGBA8888);
+    if (!surface) {
+        fprintf(stderr, "blend: setup failed\n");
+        return;
+    }
+    // A disc with a soft edge, so that every blended pixel count is realistic.
+    for (int y = 0; y < size; y++) {
+        Uint32* row = (Uint32*)((Uint8*)surface->pixels + y * surface->pitch);
+        for (int x = 0; x < size; x++) {
+            float dx = x + 0.5f - size * 0.5f, dy = y + 0.5f - size * 0.5f;
+            float coverage = fmaxf(0.0f, fminf(1.0f, size * 0.5f - sqrtf(dx * dx + dy * dy)));
+            row[x] = 0x4080C000u | (Uint32)(coverage * 255.0f);
+        }
+    }
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_FreeSurface(surface);
+    if (!texture) {
+        fprintf(stderr, "blend: texture creation failed\n");
+        return;
+    }
+
+    static const char* names[] = {"none", "blend", "premultiplied"};
+    SDL_BlendMode modes[] = {SDL_BLENDMODE_NONE, SDL_BLENDMODE_BLEND,
+                             SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                                        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD)};
+    printf("blend (%dx%d texture, ns per copy)\n", size, size);
+    for (int m = 0; m < 3; m++) {
+        if (SDL_SetTextureBlendMode(texture, modes[m]) != 0) {
+            printf("  %-14s rejected by the renderer\n", names[m]);
+            continue;
+        }
+        double best = 0.0;
+        for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+            Uint64 start = SDL_GetPerformanceCounter();
+            for (int i = 0; i < copies; i++) {
+                SDL_Rect dst = {(i * 37) % (800 - size), (i * 53) % (600 - size), size, size};
+                SDL_RenderCopy(renderer, texture, NULL, &dst);
+            }
+            SDL_RenderFlush(renderer);
+            double elapsed = seconds_since(start);
+            if (repeat == 0 || elapsed < best) best = elapsed;
+        }
+        printf("  %-14s %8.1f\n", names[m], best * 1e9 / copies);
+    }
+    SDL_DestroyTexture(texture);
+}
+
+// --- Helper Function: run_traced ---
+// Times calls of VirtualJoystick_HandleEvent (one per event) or VirtualJoystick_Draw in chunks
+// small enough for the trace buffer. While recording, the buffer is written out (untimed) after
+// each chunk, so every timed call really records its events instead of hitting a full buffer.
+// Returns: Nanoseconds per call (the fastest of BENCH_REPEATS measurements).
+static double run_traced(VirtualJoystick* joystick, SDL_Renderer* renderer, const SDL_Event* events, int count, bool draw, bool recording) {
+    const int chunk = 1024; // At most four trace events per call, well below VIRTUAL_JOYSTICK_TRACE_EVENTS.
+    double best = 0.0;
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        double elapsed = 0.0;
+        for (int first = 0; first < count; first += chunk) {
+            int last = first + chunk < count ? first + chunk : count;
+            Uint64 start = SDL_GetPerformanceCounter();
+            for (int i = first; i < last; i++) {
+                if (draw) {
+                    VirtualJoystick_Draw(joystick, renderer);
+                } else {
+                    VirtualJoystick_HandleEvent(joystick, &events[i]);
+                }
+            }
+            elapsed += seconds_since(start);
+            if (recording) VirtualJoystick_WriteTrace("joystick_bench_trace.json");
+        }
+        if (repeat == 0 || elapsed < best) best = elapsed;
+    }
+    return best * 1e9 / count;
+}
+
+// --- Benchmark: trace ---
+// Overhead of tracing on HandleEvent and Draw. Build the benchmark once normally and once with
+// -DVIRTUAL_JOYSTICK_TRACE=1: the first prints the compiled-out cost, the second the cost with
+// tracing compiled in but not started, and while recording.
+static void bench_trace(SDL_Renderer* renderer) {
+    const int window_width = 800, window_height = 600;
+    VirtualJoystick* joystick = VirtualJoystick_Create(renderer, 0, 0, 400, 400, window_width, window_height);
+    VirtualJoystickTouchSample* samples = (VirtualJoystickTouchSample*)malloc(BENCH_SAMPLES * sizeof(*samples));
+    SDL_Event* events = (SDL_Event*)calloc(BENCH_SAMPLES, sizeof(*events));
+    if (!joystick || !samples || !events) {
+        fprintf(stderr, "trace: setup failed\n");
+        VirtualJoystick_Destroy(joystick);
+        free(samples);
+        free(events);
+        return;
+    }
+    make_drag(samples, BENCH_SAMPLES, joystick->_base_default_center, joystick->clampzone_size);
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        events[i].type = SDL_FINGERMOTION;
+        events[i].tfinger.timestamp = samples[i].timestamp;
+        events[i].tfinger.fingerId = samples[i].finger_id;
+        events[i].tfinger.x = samples[i].x / window_width;
+        events[i].tfinger.y = samples[i].y / window_height;
+    }
+    VirtualJoystickTouchSample down = {JOYSTICK_TOUCH_DOWN, 1, joystick->_base_default_center.x, joystick->_base_default_center.y, 0};
+    VirtualJoystick_InjectSample(joystick, &down);
+
+    printf("trace (ns per call)\n");
+    printf("  %-26s %10s %10s\n", "tracing", "event", "draw");
+#if VIRTUAL_JOYSTICK_TRACE
+    static const char* states[] = {"compiled in, not started", "recording"};
+    for (int recording = 0; recording < 2; recording++) {
+        if (recording && !VirtualJoystick_StartTrace()) break;
+        double event_ns = run_traced(joystick, renderer, events, BENCH_SAMPLES, false, recording != 0);
+        double draw_ns = run_traced(joystick, renderer, events, BENCH_SAMPLES / 16, true, recording != 0);
+        printf("  %-26s %10.1f %10.1f\n", states[recording], event_ns, draw_ns);
+    }
+    remove("joystick_bench_trace.json");
+#else
+    double event_ns = run_traced(joystick, renderer, events, BENCH_SAMPLES, false, false);
+    double draw_ns = run_traced(joystick, renderer, events, BENCH_SAMPLES / 16, true, false);
+    printf("  %-26s %10.1f %10.1f\n", "compiled out", event_ns, draw_ns);
+#endif
+
+    free(events);
+    free(samples);
+    VirtualJoystick_Destroy(joystick);
+}
+
+// --- Benchmark Table ---
+// Every benchmark, in the order they run. Pass names on the command line to run only some.
+static const struct {
+    const char* name;
+    void (*run)(SDL_Renderer* renderer);
+} benchmarks[] = {
+    {"deadzone", bench_deadzone},
+    {"inject", bench_inject},
+    {"sources", bench_sources},
+    {"prepare", bench_prepare},
+    {"blend", bench_blend},
+    {"trace", bench_trace},
+};
+
+int main(int argc, char* args[]) {
+    if (SDL_Init(0) != 0) {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 800, 600, 32, SDL_PIXELFORMAT_RGBA8888);
+    SDL_Renderer* renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    if (!renderer) {
+        fprintf(stderr, "Could not create a software renderer: %s\n", SDL_GetError());
+        SDL_FreeSurface(surface);
+        SDL_Quit();
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+        bool selected = argc < 2;
+        for (int a = 1; a < argc && !selected; a++) {
+            selected = strcmp(args[a], benchmarks[i].name) == 0;
+        }
+        if (selected) benchmarks[i].run(renderer);
+    }
+
+    VirtualJoystick_ReleaseRenderer(renderer);
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+    SDL_Quit();
+    return 0;
+}
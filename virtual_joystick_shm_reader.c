@@ -0,0 +1,66 @@
+// Shared-memory reader for the SDL2 virtual joystick.
+// Follows the state a joystick publishes with VirtualJoystick_PublishShared from another process
+// and prints every snapshot, without touching the publishing process.
+//
+// Build and run (Linux):
+//   gcc virtual_joystick_shm_reader.c -o joystick_shm_reader -lSDL2 -lm -lrt
+//   ./joystick_shm_reader /virtual_joystick_demo
+//
+// Start the demo with --shm to have something to read.
+
+// Only the shared region layout and the inline reader helpers are needed, not the implementation.
+#include "virtual_joyistick_asets.h"
+
+#include <time.h>
+
+int main(int argc, char* args[]) {
+    const char* name = argc > 1 ? args[1] : "/virtual_joystick_demo";
+
+#if VIRTUAL_JOYSTICK_HAS_SHARED_MEMORY
+    // Map the region read-only: readers never write to it, so they cannot disturb the writer.
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open shared memory %s (is the joystick publishing?)\n", name);
+        return 1;
+    }
+    void* data = mmap(NULL, sizeof(VirtualJoystickSharedRegion), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Could not map shared memory %s\n", name);
+        return 1;
+    }
+    const VirtualJoystickSharedRegion* region = (const VirtualJoystickSharedRegion*)data;
+
+    VirtualJoystickSharedSample current;
+    if (!VirtualJoystickShared_ReadCurrent(region, &current)) {
+        fprintf(stderr, "%s is not a compatible joystick region, or its publisher stopped mid-update\n", name);
+        munmap(data, sizeof(VirtualJoystickSharedRegion));
+        return 1;
+    }
+
+    // Poll about 120 times per second and print the snapshots written since the last poll.
+    Uint32 cursor = region->write_count;
+    VirtualJoystickSharedSample samples[VIRTUAL_JOYSTICK_SHARED_RING];
+    struct timespec interval = {0, 8 * 1000 * 1000};
+    for (;;) {
+        int count = VirtualJoystickShared_ReadRecent(region, &cursor, samples, VIRTUAL_JOYSTICK_SHARED_RING);
+        if (count < 0) break;
+        for (int i = 0; i < count; i++) {
+            const VirtualJoystickSharedSample* sample = &samples[i];
+            printf("%10u ms  output (%+.3f, %+.3f)  base (%.1f, %.1f)  tip (%.1f, %.1f)%s%s\n",
+                   (unsigned)sample->timestamp, sample->output_x, sample->output_y, sample->base_x, sample->base_y,
+                   sample->tip_x, sample->tip_y, (sample->flags & JOYSTICK_SHARED_ACTIVE) ? "  active" : "",
+                   (sample->flags & JOYSTICK_SHARED_PRESSED) ? "  pressed" : "");
+        }
+        fflush(stdout);
+        nanosleep(&interval, NULL);
+    }
+
+    munmap(data, sizeof(VirtualJoystickSharedRegion));
+    return 0;
+#else
+    (void)name;
+    fprintf(stderr, "POSIX shared memory is not available on this platform\n");
+    return 1;
+#endif
+}
@@ -0,0 +1,301 @@
+// Behavior checks for the SDL2 virtual joystick.
+// Drives the library through its injection APIs (no window, input devices or GPU needed) and
+// checks the results: deadzone shapes, the shared-memory readers, twin-stick groups, gestures
+// and gyro bias tracking. Prints every failed check and exits with 1 if there was any.
+//
+// Build and run:
+//   gcc virtual_joystick_tests.c -o joystick_tests -lSDL2 -lm
+//   ./joystick_tests
+
+#define VIRTUAL_JOYSTICK_IMPLEMENTATION
+#include "virtual_joyistick_asets.h"
+
+static int failures = 0;
+
+// Records a failed check with its location, and keeps going so one run reports every failure.
+#define CHECK(condition)                                                           \
+    do {                                                                           \
+        if (!(condition)) {                                                        \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                            \
+        }                                                                          \
+    } while (0)
+
+#define NEAR(a, b, tolerance) (fabsf((a) - (b)) < (tolerance))
+
+// --- Helper Function: touch ---
+// Injects one touch sample into a joystick.
+static void touch(VirtualJoystick* joystick, JoystickTouchPhase phase, float x, float y) {
+    VirtualJoystickTouchSample sample = {phase, 1, x, y, 0};
+    VirtualJoystick_InjectSample(joystick, &sample);
+}
+
+// --- Helper Function: group_touch ---
+// Injects one touch sample into a group.
+static void group_touch(VirtualJoystickGroup* group, JoystickTouchPhase phase, int finger_id, float x, float y) {
+    VirtualJoystickTouchSample sample = {phase, finger_id, x, y, 0};
+    VirtualJoystickGroup_InjectSample(group, &sample);
+}
+
+// --- Helper Function: output_at ---
+// Touches a fixed joystick down at its center, moves the finger by (dx, dy) and returns the output
+// while the finger is still down. The finger is lifted again afterwards.
+static Vector2 output_at(VirtualJoystick* joystick, float dx, float dy, bool* is_pressed) {
+    SDL_FPoint center = joystick->_base_default_center;
+    touch(joystick, JOYSTICK_TOUCH_DOWN, center.x, center.y);
+    touch(joystick, JOYSTICK_TOUCH_MOVE, center.x + dx, center.y + dy);
+    Vector2 output = joystick->output;
+    if (is_pressed) *is_pressed = joystick->is_pressed;
+    touch(joystick, JOYSTICK_TOUCH_UP, center.x + dx, center.y + dy);
+    return output;
+}
+
+// --- Test: deadzone shapes ---
+// Deadzone 10 and clamp zone 75 around the center, so a finger 50 px away is 40/65 of the way
+// through the live range of a scaled radial deadzone and 50/75 of a plain radial one.
+static void test_deadzone(SDL_Renderer* renderer) {
+    VirtualJoystick* joystick = VirtualJoystick_Create(renderer, 0, 0, 400, 400, 800, 600);
+    CHECK(joystick != NULL);
+    if (!joystick) return;
+    joystick->joystick_mode = JOYSTICK_MODE_FIXED;
+    joystick->deadzone_size = 10.0f;
+    joystick->clampzone_size = 75.0f;
+    bool pressed = false;
+
+    Vector2 output = output_at(joystick, 30.0f, 40.0f, &pressed);
+    CHECK(NEAR(output.x, 0.6f * 40.0f / 65.0f, 1e-4f) && NEAR(output.y, 0.8f * 40.0f / 65.0f, 1e-4f) && pressed);
+
+    joystick->deadzone_shape = JOYSTICK_DEADZONE_RADIAL;
+    output = output_at(joystick, 30.0f, 40.0f, NULL);
+    CHECK(NEAR(output.x, 0.6f * 50.0f / 75.0f, 1e-4f) && NEAR(output.y, 0.8f * 50.0f / 75.0f, 1e-4f));
+
+    // Axial: each axis has its own deadzone, so a small sideways offset is dropped entirely.
+    joystick->deadzone_shape = JOYSTICK_DEADZONE_AXIAL;
+    output = output_at(joystick, 5.0f, 40.0f, NULL);
+    CHECK(output.x == 0.0f && NEAR(output.y, 40.0f / 75.0f, 1e-4f));
+
+    // Cross: like axial, but each axis is rescaled to start at zero past its deadzone.
+    joystick->deadzone_shape = JOYSTICK_DEADZONE_CROSS;
+    output = output_at(joystick, 5.0f, -40.0f, NULL);
+    CHECK(output.x == 0.0f && NEAR(output.y, -30.0f / 65.0f, 1e-4f));
+
+    // Outer deadzone: full deflection is reached 15 px before the clamp zone.
+    joystick->deadzone_shape = JOYSTICK_DEADZONE_SCALED_RADIAL;
+    joystick->outer_deadzone_size = 15.0f;
+    output = output_at(joystick, 70.0f, 0.0f, NULL);
+    CHECK(NEAR(output.x, 1.0f, 1e-4f) && output.y == 0.0f);
+    joystick->outer_deadzone_size = 0.0f;
+
+    // Axis snapping: within 10 degrees of an axis the output lies on it, further out it does not.
+    joystick->snap_angle = 10.0f;
+    output = output_at(joystick, 50.0f, 5.0f, NULL);
+    CHECK(output.x > 0.0f && output.y == 0.0f);
+    output = output_at(joystick, 50.0f, 20.0f, NULL);
+    CHECK(output.x > 0.0f && output.y > 0.0f);
+    joystick->snap_angle = 0.0f;
+
+    output = output_at(joystick, 2.0f, 1.0f, &pressed);
+    CHECK(output.x == 0.0f && output.y == 0.0f && !pressed);
+
+    VirtualJoystick_Destroy(joystick);
+}
+
+// --- Test: shared-memory readers ---
+// Runs the seqlock readers on a region in local memory, posing as a writer that stopped in the
+// middle of an update and as one that restarted.
+static void test_shared_readers(void) {
+    static VirtualJoystickSharedRegion region; // Too large for the stack of some platforms.
+    SDL_memset(&region, 0, sizeof(region));
+    region.magic = VIRTUAL_JOYSTICK_SHARED_MAGIC;
+    region.version = VIRTUAL_JOYSTICK_SHARED_VERSION;
+    region.ring_length = VIRTUAL_JOYSTICK_SHARED_RING;
+    VirtualJoystickSharedSample sample;
+    static VirtualJoystickSharedSample samples[VIRTUAL_JOYSTICK_SHARED_RING + 8];
+
+    // An odd sequence means a write is in progress; if it never ends, reads give up.
+    region.sequence = 3;
+    region.write_count = 5;
+    Uint32 cursor = 0;
+    CHECK(!VirtualJoystickShared_ReadCurrent(&region, &sample));
+    CHECK(VirtualJoystickShared_ReadRecent(&region, &cursor, samples, 8) == 0 && cursor == 0);
+
+    // Once the write completes, both readers succeed.
+    region.sequence = 4;
+    region.current.timestamp = 42;
+    for (Uint32 i = 0; i < 5; i++) {
+        region.ring[i].timestamp = 100 + i;
+    }
+    CHECK(VirtualJoystickShared_ReadCurrent(&region, &sample) && sample.timestamp == 42);
+    int count = VirtualJoystickShared_ReadRecent(&region, &cursor, samples, 8);
+    CHECK(count == 5 && cursor == 5 && samples[0].timestamp == 100 && samples[4].timestamp == 104);
+    CHECK(VirtualJoystickShared_ReadRecent(&region, &cursor, samples, 8) == 0 && cursor == 5);
+
+    // A publisher that restarted has written fewer samples than the cursor: start over.
+    region.write_count = 2;
+    cursor = 1000;
+    count = VirtualJoystickShared_ReadRecent(&region, &cursor, samples, 8);
+    CHECK(count == 2 && cursor == 2 && samples[0].timestamp == 100);
+
+    // A reader more than a ring behind skips to the oldest snapshot still in the ring.
+    region.write_count = VIRTUAL_JOYSTICK_SHARED_RING + 10;
+    cursor = 0;
+    count = VirtualJoystickShared_ReadRecent(&region, &cursor, samples, VIRTUAL_JOYSTICK_SHARED_RING + 8);
+    CHECK(count == VIRTUAL_JOYSTICK_SHARED_RING && cursor == VIRTUAL_JOYSTICK_SHARED_RING + 10);
+
+    // Regions of another layout are rejected.
+    region.version = VIRTUAL_JOYSTICK_SHARED_VERSION + 1;
+    CHECK(!VirtualJoystickShared_ReadCurrent(&region, &sample));
+    CHECK(VirtualJoystickShared_ReadRecent(&region, &cursor, samples, 8) == -1);
+}
+
+// --- Test: group assignment ---
+// Each new finger goes to the nearest free stick; fingers beyond the number of sticks are ignored.
+static void test_group(SDL_Renderer* renderer) {
+    VirtualJoystick* left = VirtualJoystick_Create(renderer, 0, 0, 400, 600, 800, 600);
+    VirtualJoystick* right = VirtualJoystick_Create(renderer, 400, 0, 400, 600, 800, 600);
+    VirtualJoystickGroup* group = VirtualJoystickGroup_Create(0, 0, 800, 600, 800, 600);
+    CHECK(left && right && group);
+    if (!left || !right || !group) return;
+    left->joystick_mode = right->joystick_mode = JOYSTICK_MODE_DYNAMIC;
+    left->clampzone_size = right->clampzone_size = 75.0f;
+    CHECK(VirtualJoystickGroup_AddStick(group, left) && VirtualJoystickGroup_AddStick(group, right));
+
+    group_touch(group, JOYSTICK_TOUCH_DOWN, 1, 600.0f, 300.0f);
+    CHECK(VirtualJoystick_IsActive(right) && !VirtualJoystick_IsActive(left));
+    // The right stick is taken, so the next finger gets the left one even on the right side.
+    group_touch(group, JOYSTICK_TOUCH_DOWN, 2, 650.0f, 300.0f);
+    CHECK(VirtualJoystick_IsActive(left));
+    group_touch(group, JOYSTICK_TOUCH_DOWN, 3, 100.0f, 300.0f);
+    group_touch(group, JOYSTICK_TOUCH_MOVE, 3, 0.0f, 300.0f);
+    CHECK(left->output.x == 0.0f); // The third finger has no stick.
+    group_touch(group, JOYSTICK_TOUCH_MOVE, 2, 750.0f, 300.0f);
+    CHECK(NEAR(left->output.x, 1.0f, 1e-4f) && right->output.x == 0.0f);
+
+    group_touch(group, JOYSTICK_TOUCH_UP, 1, 600.0f, 300.0f);
+    CHECK(!VirtualJoystick_IsActive(right));
+    group_touch(group, JOYSTICK_TOUCH_DOWN, 4, 700.0f, 300.0f);
+    CHECK(VirtualJoystick_IsActive(right));
+
+    VirtualJoystickGroup_Destroy(group);
+    VirtualJoystick_Destroy(left);
+    VirtualJoystick_Destroy(right);
+}
+
+// --- Test: gesture start ---
+// A second finger starts a two-finger gesture only when it lands on the stick the first finger
+// holds and that stick is idle, unless steal_sticks lets it take a stick in use.
+static void test_gesture(SDL_Renderer* renderer) {
+    VirtualJoystick* left = VirtualJoystick_Create(renderer, 0, 0, 400, 600, 800, 600);
+    VirtualJoystick* right = VirtualJoystick_Create(renderer, 400, 0, 400, 600, 800, 600);
+    VirtualJoystickGroup* group = VirtualJoystickGroup_Create(0, 0, 800, 600, 800, 600);
+    VirtualJoystickGesture* gesture = VirtualJoystickGesture_Create(0, 0, 800, 600);
+    CHECK(left && right && group && gesture);
+    if (!left || !right || !group || !gesture) return;
+    left->joystick_mode = right->joystick_mode = JOYSTICK_MODE_DYNAMIC;
+    VirtualJoystickGroup_AddStick(group, left);
+    VirtualJoystickGroup_AddStick(group, right);
+    VirtualJoystickGroup_SetGesture(group, gesture);
+
+    // Both thumbs on their own sticks.
+    group_touch(group, JOYSTICK_TOUCH_DOWN, 1, 100.0f, 300.0f);
+    group_touch(group, JOYSTICK_TOUCH_DOWN, 2, 600.0f, 300.0f);
+    CHECK(!gesture->active && VirtualJoystick_IsActive(left) && VirtualJoystick_IsActive(right));
+    group_touch(group, JOYSTICK_TOUCH_UP, 2, 600.0f, 300.0f);
+    group_touch(group, JOYSTICK_TOUCH_UP, 1, 100.0f, 300.0f);
+
+    // A second finger on the same idle stick pairs with the first.
+    group_touch(group, JOYSTICK_TOUCH_DOWN, 1, 100.0f, 300.0f);
+    group_touch(group, JOYSTICK_TOUCH_DOWN, 2, 150.0f, 300.0f);
+    CHECK(gesture->active && !VirtualJoystick_IsActive(left) && !VirtualJoystick_IsActive(right));
+    group_touch(group, JOYSTICK_TOUCH_MOVE, 2, 200.0f, 300.0f);
+    CHECK(NEAR(gesture->scale, 2.0f, 1e-4f));
+    group_touch(group, JOYSTICK_TOUCH_UP, 2, 200.0f, 300.0f);
+    group_touch(group, JOYSTICK_TOUCH_UP, 1, 100.0f, 300.0f);
+    CHECK(!gesture->active);
+
+    // A pressed stick keeps its finger; the second finger goes to the free stick.
+    group_touch(group, JOYSTICK_TOUCH_DOWN, 1, 100.0f, 300.0f);
+    group_touch(group, JOYSTICK_TOUCH_MOVE, 1, 160.0f, 300.0f);
+    group_touch(group, JOYSTICK_TOUCH_DOWN, 2, 150.0f, 300.0f);
+    CHECK(!gesture->active && VirtualJoystick_IsActive(left) && VirtualJoystick_IsActive(right));
+    group_touch(group, JOYSTICK_TOUCH_UP, 2, 150.0f, 300.0f);
+
+    // With steal_sticks, the gesture takes over the pressed stick.
+    gesture->steal_sticks = true;
+    group_touch(group, JOYSTICK_TOUCH_DOWN, 3, 150.0f, 300.0f);
+    CHECK(gesture->active && !VirtualJoystick_IsActive(left) && !left->is_pressed);
+    group_touch(group, JOYSTICK_TOUCH_UP, 3, 150.0f, 300.0f);
+    group_touch(group, JOYSTICK_TOUCH_UP, 1, 160.0f, 300.0f);
+
+    VirtualJoystickGroup_Destroy(group);
+    VirtualJoystickGesture_Destroy(gesture);
+    VirtualJoystick_Destroy(left);
+    VirtualJoystick_Destroy(right);
+}
+
+// --- Test: gyro bias ---
+// A gyro that reads a constant drift while the device lies still is calibrated out within a few
+// seconds, and turns are measured relative to the learned bias.
+static void test_gyro_bias(void) {
+    VirtualJoystickAim* aim = VirtualJoystickAim_Create(NULL);
+    CHECK(aim != NULL);
+    if (!aim) return;
+    const float drift[3] = {0.01f, 0.02f, -0.01f};
+    Uint32 timestamp = 0;
+    for (int i = 0; i < 800; i++, timestamp += 10) {
+        VirtualJoystickAim_InjectGyro(aim, drift, timestamp);
+    }
+    CHECK(NEAR(aim->bias[0], drift[0], 1e-3f) && NEAR(aim->bias[1], drift[1], 1e-3f) && NEAR(aim->bias[2], drift[2], 1e-3f));
+
+    VirtualJoystickAim_Consume(aim, 0.0f);
+    for (int i = 0; i < 100; i++, timestamp += 10) {
+        VirtualJoystickAim_InjectGyro(aim, drift, timestamp);
+    }
+    Vector2 aim_delta = VirtualJoystickAim_Consume(aim, 0.0f);
+    CHECK(NEAR(aim_delta.x, 0.0f, 1e-3f) && NEAR(aim_delta.y, 0.0f, 1e-3f));
+
+    // Turning left at 1 rad/s for half a second, on top of the drift. The bias stays put.
+    const float turn[3] = {drift[0], drift[1] + 1.0f, drift[2]};
+    for (int i = 0; i < 50; i++, timestamp += 10) {
+        VirtualJoystickAim_InjectGyro(aim, turn, timestamp);
+    }
+    aim_delta = VirtualJoystickAim_Consume(aim, 0.0f);
+    CHECK(NEAR(aim_delta.x, -0.5f, 0.01f) && NEAR(aim->bias[1], drift[1], 1e-3f));
+
+    VirtualJoystickAim_Destroy(aim);
+}
+
+int main(int argc, char* args[]) {
+    (void)argc;
+    (void)args;
+    if (SDL_Init(0) < 0) {
+        fprintf(stderr, "SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 800, 600, 32, SDL_PIXELFORMAT_RGBA8888);
+    SDL_Renderer* renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    if (!renderer) {
+        fprintf(stderr, "Software renderer could not be created! SDL_Error: %s\n", SDL_GetError());
+        SDL_FreeSurface(surface);
+        SDL_Quit();
+        return 1;
+    }
+
+    test_deadzone(renderer);
+    test_shared_readers();
+    test_group(renderer);
+    test_gesture(renderer);
+    test_gyro_bias();
+
+    VirtualJoystick_ReleaseRenderer(renderer);
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+    SDL_Quit();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}